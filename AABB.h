@@ -0,0 +1,13 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// Axis-aligned bounding box (same layout as PhysicsObject::minBounds/maxBounds)
+struct AABB {
+    glm::vec2 min;
+    glm::vec2 max;
+
+    bool overlaps(const AABB& other) const {
+        return !(max.x < other.min.x || min.x > other.max.x ||
+                 max.y < other.min.y || min.y > other.max.y);
+    }
+};
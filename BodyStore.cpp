@@ -0,0 +1,267 @@
+#include "BodyStore.h"
+#include "Narrowphase.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+// 用最后一行覆盖被删除的行，O(1)
+template<typename T>
+void swapRemoveAt(std::vector<T>& values, uint32_t index, uint32_t last) {
+    if (index != last) {
+        values[index] = std::move(values[last]);
+    }
+    values.pop_back();
+}
+
+template<typename T>
+void swapAt(std::vector<T>& values, uint32_t i, uint32_t j) {
+    std::swap(values[i], values[j]);
+}
+
+} // namespace
+
+uint32_t BodyStore::add(const std::vector<BodyVertex>& verts, float mass) {
+    return add(ShapeLibrary::shared().get(verts), mass);
+}
+
+uint32_t BodyStore::add(ShapeRef shape, float mass) {
+    uint32_t index = static_cast<uint32_t>(size());
+
+    positions.push_back(glm::vec2(0.0f));
+    previousPositions.push_back(glm::vec2(0.0f));
+    velocities.push_back(glm::vec2(0.0f));
+    accelerations.push_back(glm::vec2(0.0f));
+    masses.push_back(mass);
+    inverseMasses.push_back(mass > 0.0f ? 1.0f / mass : 0.0f);
+    elasticities.push_back(0.8f);
+    frictions.push_back(0.1f);
+    deformations.push_back(0.0f);
+    sleepTimes.push_back(0.0f);
+    localBounds.push_back(shape->getLocalBounds());
+    bounds.push_back(shape->getLocalBounds());
+    shapes.push_back(std::move(shape));
+    deformedVertices.emplace_back();
+    deformed.push_back(0);
+
+    return index;
+}
+
+uint32_t BodyStore::copyFrom(const BodyStore& other, uint32_t i) {
+    uint32_t index = static_cast<uint32_t>(size());
+
+    positions.push_back(other.positions[i]);
+    previousPositions.push_back(other.previousPositions[i]);
+    velocities.push_back(other.velocities[i]);
+    accelerations.push_back(other.accelerations[i]);
+    masses.push_back(other.masses[i]);
+    inverseMasses.push_back(other.inverseMasses[i]);
+    elasticities.push_back(other.elasticities[i]);
+    frictions.push_back(other.frictions[i]);
+    deformations.push_back(other.deformations[i]);
+    sleepTimes.push_back(other.sleepTimes[i]);
+    bounds.push_back(other.bounds[i]);
+    shapes.push_back(other.shapes[i]);
+    localBounds.push_back(other.localBounds[i]);
+    deformedVertices.push_back(other.deformed[i] ? other.deformedVertices[i] : std::vector<BodyVertex>());
+    deformed.push_back(other.deformed[i]);
+
+    return index;
+}
+
+bool BodyStore::swapRemove(uint32_t index) {
+    uint32_t last = static_cast<uint32_t>(size()) - 1;
+    bool moved = index != last;
+
+    swapRemoveAt(positions, index, last);
+    swapRemoveAt(previousPositions, index, last);
+    swapRemoveAt(velocities, index, last);
+    swapRemoveAt(accelerations, index, last);
+    swapRemoveAt(masses, index, last);
+    swapRemoveAt(inverseMasses, index, last);
+    swapRemoveAt(elasticities, index, last);
+    swapRemoveAt(frictions, index, last);
+    swapRemoveAt(deformations, index, last);
+    swapRemoveAt(sleepTimes, index, last);
+    swapRemoveAt(bounds, index, last);
+    swapRemoveAt(shapes, index, last);
+    swapRemoveAt(localBounds, index, last);
+    swapRemoveAt(deformedVertices, index, last);
+    swapRemoveAt(deformed, index, last);
+
+    return moved;
+}
+
+void BodyStore::swapRows(uint32_t i, uint32_t j) {
+    if (i == j) return;
+    swapAt(positions, i, j);
+    swapAt(previousPositions, i, j);
+    swapAt(velocities, i, j);
+    swapAt(accelerations, i, j);
+    swapAt(masses, i, j);
+    swapAt(inverseMasses, i, j);
+    swapAt(elasticities, i, j);
+    swapAt(frictions, i, j);
+    swapAt(deformations, i, j);
+    swapAt(sleepTimes, i, j);
+    swapAt(bounds, i, j);
+    swapAt(shapes, i, j);
+    swapAt(localBounds, i, j);
+    swapAt(deformedVertices, i, j);
+    swapAt(deformed, i, j);
+}
+
+void BodyStore::clear() {
+    positions.clear();
+    previousPositions.clear();
+    velocities.clear();
+    accelerations.clear();
+    masses.clear();
+    inverseMasses.clear();
+    elasticities.clear();
+    frictions.clear();
+    deformations.clear();
+    sleepTimes.clear();
+    bounds.clear();
+    shapes.clear();
+    localBounds.clear();
+    deformedVertices.clear();
+    deformed.clear();
+}
+
+void BodyStore::setMass(uint32_t index, float mass) {
+    masses[index] = mass;
+    inverseMasses[index] = mass > 0.0f ? 1.0f / mass : 0.0f;
+}
+
+void BodyStore::teleport(uint32_t index, const glm::vec2& position) {
+    positions[index] = position;
+    previousPositions[index] = position;
+    updateGeometry(index);
+}
+
+void BodyStore::integrate(uint32_t i, float deltaTime) {
+    // 更新速度和位置
+    velocities[i] += accelerations[i] * deltaTime;
+    positions[i] += velocities[i] * deltaTime;
+
+    // 重置加速度
+    accelerations[i] = glm::vec2(0.0f);
+}
+
+void BodyStore::updateGeometry(uint32_t i) {
+    // 只平移局部包围盒，顶点等到需要时再生成
+    bounds[i] = {localBounds[i].min + positions[i], localBounds[i].max + positions[i]};
+    deformed[i] = 0;
+}
+
+void BodyStore::copyWorldVertices(uint32_t i, BodyVertex* out, float alpha) const {
+    // 在上一步和当前位置之间插值
+    glm::vec2 position = alpha >= 1.0f ? positions[i] : glm::mix(previousPositions[i], positions[i], alpha);
+
+    if (deformed[i]) {
+        glm::vec2 offset = position - positions[i];
+        for (size_t v = 0; v < deformedVertices[i].size(); v++) {
+            out[v].position = deformedVertices[i][v].position + offset;
+            out[v].color = deformedVertices[i][v].color;
+        }
+        return;
+    }
+
+    // 更新顶点位置
+    const std::vector<BodyVertex>& local = shapes[i]->getVertices();
+    for (size_t v = 0; v < local.size(); v++) {
+        out[v].position = local[v].position + position;
+        out[v].color = local[v].color;
+    }
+}
+
+std::vector<BodyVertex> BodyStore::getWorldVertices(uint32_t i) const {
+    std::vector<BodyVertex> world(getVertexCount(i));
+    copyWorldVertices(i, world.data());
+    return world;
+}
+
+void BodyStore::deform(uint32_t i, const glm::vec2& impactPoint, float force) {
+    // 简单的变形效果：根据冲击力调整顶点位置
+    deformations[i] += force * 0.01f;
+    deformations[i] = std::min(deformations[i], 0.3f); // 限制最大变形
+
+    // 第一次变形时才复制一份顶点，共享的形状不改动；下一步移动后恢复原形
+    if (!deformed[i]) {
+        deformedVertices[i].resize(getVertexCount(i));
+        copyWorldVertices(i, deformedVertices[i].data());
+        deformed[i] = 1;
+    }
+    for (auto& vertex : deformedVertices[i]) {
+        glm::vec2 toImpact = impactPoint - vertex.position;
+        float distance = glm::length(toImpact);
+        if (distance > 0.001f) {
+            float deformationFactor = deformations[i] / (1.0f + distance);
+            vertex.position += glm::normalize(toImpact) * deformationFactor * 0.1f;
+        }
+    }
+}
+
+bool BodyStore::checkCollision(const BodyStore& storeA, uint32_t a, const BodyStore& storeB, uint32_t b) {
+    if (!storeA.bounds[a].overlaps(storeB.bounds[b])) return false;
+    const Shape& shapeA = *storeA.shapes[a];
+    const Shape& shapeB = *storeB.shapes[b];
+    // 没有凸包的形状只比较包围盒
+    if (shapeA.getHull().empty() || shapeB.getHull().empty()) return true;
+    ContactManifold manifold;
+    if (shapeA.isRounded() || shapeB.isRounded()) {
+        SimplexCache simplex;
+        return collideConvex(shapeA, storeA.positions[a], shapeB, storeB.positions[b], manifold, simplex);
+    }
+    SeparatingAxis axis;
+    return collidePolygons(shapeA, storeA.positions[a], shapeB, storeB.positions[b], manifold, axis);
+}
+
+void BodyStore::resolveCollision(BodyStore& storeA, uint32_t a, BodyStore& storeB, uint32_t b) {
+    if (!storeA.bounds[a].overlaps(storeB.bounds[b])) return;
+
+    // 凸包用分离轴测试，圆角形状用 GJK；没有凸包时法线取包围盒重叠最小的轴。法线从 a 指向 b
+    glm::vec2 normal(0.0f);
+    float depth = 0.0f;
+    const Shape& shapeA = *storeA.shapes[a];
+    const Shape& shapeB = *storeB.shapes[b];
+    if (!shapeA.getHull().empty() && !shapeB.getHull().empty()) {
+        ContactManifold manifold;
+        SeparatingAxis axis;
+        SimplexCache simplex;
+        bool touching = shapeA.isRounded() || shapeB.isRounded()
+                            ? collideConvex(shapeA, storeA.positions[a], shapeB, storeB.positions[b], manifold, simplex)
+                            : collidePolygons(shapeA, storeA.positions[a], shapeB, storeB.positions[b], manifold, axis);
+        if (!touching) return;
+        normal = manifold.normal;
+        for (uint32_t p = 0; p < manifold.pointCount; p++) depth = std::max(depth, manifold.points[p].depth);
+    } else {
+        const AABB& boundsA = storeA.bounds[a];
+        const AABB& boundsB = storeB.bounds[b];
+        glm::vec2 overlap = glm::min(boundsA.max, boundsB.max) - glm::max(boundsA.min, boundsB.min);
+        glm::vec2 delta = (boundsB.min + boundsB.max) - (boundsA.min + boundsA.max);
+        int axis = overlap.x < overlap.y ? 0 : 1;
+        normal[axis] = delta[axis] >= 0.0f ? 1.0f : -1.0f;
+        depth = overlap[axis];
+    }
+
+    float inverseMassSum = storeA.inverseMasses[a] + storeB.inverseMasses[b];
+    if (inverseMassSum <= 0.0f) return;
+
+    // 计算碰撞响应
+    float relativeVelocity = glm::dot(storeB.velocities[b] - storeA.velocities[a], normal);
+    if (relativeVelocity < 0) {
+        float restitution = (storeA.elasticities[a] + storeB.elasticities[b]) * 0.5f;
+        float impulse = -(1.0f + restitution) * relativeVelocity / inverseMassSum;
+        storeA.velocities[a] -= impulse * normal * storeA.inverseMasses[a];
+        storeB.velocities[b] += impulse * normal * storeB.inverseMasses[b];
+    }
+
+    // 按质量比例分开到刚好接触
+    glm::vec2 separation = normal * (depth / inverseMassSum);
+    storeA.positions[a] -= separation * storeA.inverseMasses[a];
+    storeB.positions[b] += separation * storeB.inverseMasses[b];
+    storeA.updateGeometry(a);
+    storeB.updateGeometry(b);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "AABB.h"
+#include "ShapeLibrary.h"
+
+// Stable reference to a body in a PhysicsEngine: slot index plus the generation the slot had when
+// the body was created. Removing the body bumps the generation, so old handles are detected as stale.
+struct BodyHandle {
+    static constexpr uint32_t invalidIndex = 0xFFFFFFFFu;
+
+    uint32_t index = invalidIndex;
+    uint32_t generation = 0;
+
+    bool operator==(const BodyHandle& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const BodyHandle& other) const { return !(*this == other); }
+};
+
+// Creation parameters for bodies added without a PhysicsObject
+struct BodyDesc {
+    ShapeRef shape;                   // used if set, otherwise vertices are interned in ShapeLibrary::shared()
+    std::vector<BodyVertex> vertices;
+    float mass = 1.0f;
+    glm::vec2 position = glm::vec2(0.0f);
+    glm::vec2 velocity = glm::vec2(0.0f);
+    float elasticity = 0.8f;
+    float friction = 0.1f;
+};
+
+// Structure-of-arrays storage for all bodies of an engine. Index i of every array belongs to the
+// same body, so the per-step loops stream over contiguous memory instead of chasing one
+// heap object per body. PhysicsObject is a handle (store + index) into one of these.
+class BodyStore {
+public:
+    // Simulation state. previousPositions holds the positions at the start of the last step,
+    // for render interpolation.
+    std::vector<glm::vec2> positions;
+    std::vector<glm::vec2> previousPositions;
+    std::vector<glm::vec2> velocities;
+    std::vector<glm::vec2> accelerations;
+
+    // Material
+    std::vector<float> masses;
+    std::vector<float> inverseMasses;
+    std::vector<float> elasticities;
+    std::vector<float> frictions;
+    std::vector<float> deformations;
+
+    // Seconds the body has spent below the engine's sleep velocity
+    std::vector<float> sleepTimes;
+
+    // World-space bounds, fed straight to the broadphase. Derived from localBounds + position.
+    std::vector<AABB> bounds;
+
+    // Shared local-space geometry. localBounds repeats the shape's bounds so the per-step
+    // bounds update streams over one array.
+    std::vector<ShapeRef> shapes;
+    std::vector<AABB> localBounds;
+
+    // Copy-on-write world-space vertices: deform() copies the shape into the body's own storage
+    // and edits that copy; the next step drops back to the shared shape.
+    std::vector<std::vector<BodyVertex>> deformedVertices;
+    std::vector<uint8_t> deformed;
+
+    size_t size() const { return positions.size(); }
+    bool empty() const { return positions.empty(); }
+
+    uint32_t add(ShapeRef shape, float mass);
+    uint32_t add(const std::vector<BodyVertex>& verts, float mass);
+    // Appends a copy of body `index` of another store
+    uint32_t copyFrom(const BodyStore& other, uint32_t index);
+    // Removes body `index` by moving the last body into its row. Returns true if a body was moved.
+    bool swapRemove(uint32_t index);
+    // Exchanges two rows
+    void swapRows(uint32_t i, uint32_t j);
+    void clear();
+
+    void setMass(uint32_t index, float mass);
+    // Moves a body without interpolating from its old position
+    void teleport(uint32_t index, const glm::vec2& position);
+
+    // World-space vertices of a body: the deformed copy, or the shape moved to the body position.
+    // alpha < 1 places the body between its previous and current position.
+    void copyWorldVertices(uint32_t index, BodyVertex* out, float alpha = 1.0f) const;
+    std::vector<BodyVertex> getWorldVertices(uint32_t index) const;
+    size_t getVertexCount(uint32_t index) const { return shapes[index]->getVertices().size(); }
+
+    // Per-body kernels
+    void integrate(uint32_t index, float deltaTime);
+    // O(1): moves the bounds with the position and drops any deformed copy
+    void updateGeometry(uint32_t index);
+    void deform(uint32_t index, const glm::vec2& impactPoint, float force);
+
+    // Pair kernels; the two bodies may live in different stores. Both test the convex hulls with the
+    // separating axis test, round shapes with GJK (bounds only for shapes without a hull). resolveCollision is a one-shot
+    // response (bounce plus separation along the contact normal); the engine uses ContactSolver.
+    static bool checkCollision(const BodyStore& storeA, uint32_t a, const BodyStore& storeB, uint32_t b);
+    static void resolveCollision(BodyStore& storeA, uint32_t a, BodyStore& storeB, uint32_t b);
+};
@@ -0,0 +1,828 @@
+#include "Broadphase.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+
+// 浮点坐标转格子坐标，限制范围防止溢出
+int toCell(float value, float invCellSize) {
+    float cell = std::floor(value * invCellSize);
+    cell = std::clamp(cell, -1.0e9f, 1.0e9f);
+    return static_cast<int>(cell);
+}
+
+uint64_t packCell(int x, int y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+float maxExtent(const AABB& box) {
+    glm::vec2 extent = box.max - box.min;
+    return std::max(extent.x, extent.y);
+}
+
+// 用平均尺寸的两倍作为格子大小，大部分物体只占 1~4 个格子
+float autoCellSize(double totalExtent, size_t count) {
+    float average = static_cast<float>(totalExtent / count);
+    return average > 1e-6f ? average * 2.0f : 1.0f;
+}
+
+bool pairLess(const BroadphasePair& lhs, const BroadphasePair& rhs) {
+    return lhs.a != rhs.a ? lhs.a < rhs.a : lhs.b < rhs.b;
+}
+
+BroadphasePair makePair(uint32_t i, uint32_t j) {
+    return i < j ? BroadphasePair{i, j} : BroadphasePair{j, i};
+}
+
+uint64_t pairKey(uint32_t i, uint32_t j) {
+    return i < j ? (static_cast<uint64_t>(i) << 32) | j : (static_cast<uint64_t>(j) << 32) | i;
+}
+
+BroadphasePair keyToPair(uint64_t key) {
+    return {static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key)};
+}
+
+void keysToPairs(const std::vector<uint64_t>& keys, std::vector<BroadphasePair>& pairs) {
+    pairs.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        pairs[i] = keyToPair(keys[i]);
+    }
+}
+
+// 按线程数决定分块数量，每块至少 minChunkSize 个元素
+uint32_t chunkCountFor(JobSystem* jobs, size_t count, size_t minChunkSize) {
+    size_t threads = jobs ? jobs->getThreadCount() : 1;
+    size_t chunks = std::min(threads * 4, (count + minChunkSize - 1) / minChunkSize);
+    return static_cast<uint32_t>(std::max<size_t>(chunks, 1));
+}
+
+uint32_t chunkBegin(uint32_t count, uint32_t chunks, uint32_t chunk) {
+    return static_cast<uint32_t>(static_cast<uint64_t>(count) * chunk / chunks);
+}
+
+// 有 JobSystem 时各块并行执行，否则按顺序执行
+template<typename Function>
+void forEachChunk(JobSystem* jobs, uint32_t chunks, Function&& fn) {
+    if (jobs) {
+        jobs->parallelFor(chunks, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t chunk = begin; chunk < end; chunk++) fn(chunk);
+        });
+    } else {
+        for (uint32_t chunk = 0; chunk < chunks; chunk++) fn(chunk);
+    }
+}
+
+// 各块分别排序，再两两归并
+template<typename T, typename Less>
+void parallelSort(JobSystem* jobs, std::vector<T>& values, std::vector<T>& scratch, Less less) {
+    const uint32_t count = static_cast<uint32_t>(values.size());
+    uint32_t chunks = chunkCountFor(jobs, count, 4096);
+    if (chunks == 1) {
+        std::sort(values.begin(), values.end(), less);
+        return;
+    }
+
+    forEachChunk(jobs, chunks, [&](uint32_t chunk) {
+        std::sort(values.begin() + chunkBegin(count, chunks, chunk), values.begin() + chunkBegin(count, chunks, chunk + 1), less);
+    });
+
+    scratch.resize(count);
+    for (uint32_t width = 1; width < chunks; width *= 2) {
+        uint32_t merges = (chunks + 2 * width - 1) / (2 * width);
+        forEachChunk(jobs, merges, [&](uint32_t merge) {
+            uint32_t lo = chunkBegin(count, chunks, merge * 2 * width);
+            uint32_t mid = chunkBegin(count, chunks, std::min(chunks, merge * 2 * width + width));
+            uint32_t hi = chunkBegin(count, chunks, std::min(chunks, (merge + 1) * 2 * width));
+            std::merge(values.begin() + lo, values.begin() + mid, values.begin() + mid, values.begin() + hi,
+                       scratch.begin() + lo, less);
+        });
+        values.swap(scratch);
+    }
+}
+
+void concatenate(const std::vector<std::vector<BroadphasePair>>& chunks, std::vector<BroadphasePair>& pairs) {
+    size_t total = 0;
+    for (const auto& chunk : chunks) total += chunk.size();
+    pairs.clear();
+    pairs.reserve(total);
+    for (const auto& chunk : chunks) {
+        pairs.insert(pairs.end(), chunk.begin(), chunk.end());
+    }
+}
+
+} // namespace
+
+std::unique_ptr<Broadphase> createBroadphase(BroadphaseType type) {
+    switch (type) {
+    case BroadphaseType::BruteForce:
+        return std::make_unique<BruteForceBroadphase>();
+    case BroadphaseType::SpatialHash:
+        return std::make_unique<SpatialHashBroadphase>();
+    case BroadphaseType::SweepAndPrune:
+        return std::make_unique<SweepAndPruneBroadphase>();
+    case BroadphaseType::DynamicTree:
+        return std::make_unique<DynamicTreeBroadphase>();
+    }
+    return nullptr;
+}
+
+// Broadphase 实现
+void Broadphase::createProxy(uint32_t id, const AABB& box, bool moving) {
+    if (id >= proxyStates.size()) {
+        proxyStates.resize(id + 1, ProxyState::None);
+        proxyBoxes.resize(id + 1);
+        staticSlots.resize(id + 1);
+    }
+    proxyBoxes[id] = box;
+    proxyStates[id] = moving ? ProxyState::Moving : ProxyState::Static;
+    if (!moving) addStatic(id);
+}
+
+void Broadphase::destroyProxy(uint32_t id) {
+    if (isStatic(id)) removeStatic(id);
+    proxyStates[id] = ProxyState::None;
+}
+
+void Broadphase::setProxyMoving(uint32_t id, bool moving, const AABB& box) {
+    proxyBoxes[id] = box;
+    if (moving == (proxyStates[id] == ProxyState::Moving)) return;
+    proxyStates[id] = moving ? ProxyState::Moving : ProxyState::Static;
+    if (moving) {
+        removeStatic(id);
+    } else {
+        addStatic(id);
+    }
+}
+
+void Broadphase::reset() {
+    proxyStates.clear();
+    proxyBoxes.clear();
+    staticProxies.clear();
+    staticSlots.clear();
+    indexIds.clear();
+    staticVersion++;
+}
+
+void Broadphase::computePairs(const std::vector<AABB>& bounds, std::vector<BroadphasePair>& pairs) {
+    // 下标就是代理编号，全部算移动的；数量变化时重建
+    const uint32_t count = static_cast<uint32_t>(bounds.size());
+    if (indexIds.size() != count) {
+        reset();
+        for (uint32_t i = 0; i < count; i++) {
+            createProxy(i, bounds[i], true);
+        }
+        indexIds.resize(count);
+        for (uint32_t i = 0; i < count; i++) indexIds[i] = i;
+    }
+    updatePairs(bounds, indexIds, count, pairs);
+}
+
+void Broadphase::addStatic(uint32_t id) {
+    staticSlots[id] = static_cast<uint32_t>(staticProxies.size());
+    staticProxies.push_back(id);
+    staticVersion++;
+}
+
+void Broadphase::removeStatic(uint32_t id) {
+    // 和最后一个交换后删除
+    uint32_t slot = staticSlots[id];
+    uint32_t last = staticProxies.back();
+    staticProxies[slot] = last;
+    staticSlots[last] = slot;
+    staticProxies.pop_back();
+    staticVersion++;
+}
+
+// BruteForceBroadphase 实现
+void BruteForceBroadphase::updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                                       std::vector<BroadphasePair>& pairs) {
+    // 每块处理一段连续的移动物体，和后面的移动物体以及所有静态代理测试
+    const uint32_t count = movingCount;
+    uint32_t chunks = chunkCountFor(jobs, count, 64);
+    chunkPairs.resize(chunks);
+    forEachChunk(jobs, chunks, [&](uint32_t chunk) {
+        std::vector<BroadphasePair>& out = chunkPairs[chunk];
+        out.clear();
+        for (uint32_t i = chunkBegin(count, chunks, chunk); i < chunkBegin(count, chunks, chunk + 1); i++) {
+            for (uint32_t j = i + 1; j < count; j++) {
+                if (bounds[i].overlaps(bounds[j])) {
+                    out.push_back(makePair(ids[i], ids[j]));
+                }
+            }
+            for (uint32_t other : staticProxies) {
+                if (bounds[i].overlaps(proxyBoxes[other])) {
+                    out.push_back(makePair(ids[i], other));
+                }
+            }
+        }
+    });
+    concatenate(chunkPairs, pairs);
+    parallelSort(jobs, pairs, scratchPairs, pairLess);
+}
+
+// SpatialHashBroadphase 实现
+SpatialHashBroadphase::SpatialHashBroadphase(float size) : cellSize(size), maxCellsPerBody(64) {}
+
+void SpatialHashBroadphase::updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                                        std::vector<BroadphasePair>& pairs) {
+    pairs.clear();
+    if (movingCount == 0) return;
+    if (staticGrid.version != staticVersion) buildStaticGrid();
+
+    const uint32_t count = movingCount;
+    float size = cellSize;
+    if (size <= 0.0f) {
+        double total = 0.0;
+        for (uint32_t i = 0; i < count; i++) total += maxExtent(bounds[i]);
+        size = autoCellSize(total, count);
+    }
+    float invSize = 1.0f / size;
+
+    auto cellRange = [&](uint32_t i, int& x0, int& y0, int& x1, int& y1) {
+        x0 = toCell(bounds[i].min.x, invSize);
+        y0 = toCell(bounds[i].min.y, invSize);
+        x1 = toCell(bounds[i].max.x, invSize);
+        y1 = toCell(bounds[i].max.y, invSize);
+        return static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+    };
+
+    // 先数出每个物体占几个格子，超大物体不进格子
+    entryOffsets.resize(count + 1);
+    uint32_t bodyChunks = chunkCountFor(jobs, count, 1024);
+    forEachChunk(jobs, bodyChunks, [&](uint32_t chunk) {
+        for (uint32_t i = chunkBegin(count, bodyChunks, chunk); i < chunkBegin(count, bodyChunks, chunk + 1); i++) {
+            int x0, y0, x1, y1;
+            int64_t cellCount = cellRange(i, x0, y0, x1, y1);
+            entryOffsets[i] = cellCount > maxCellsPerBody ? 0 : static_cast<uint32_t>(cellCount);
+        }
+    });
+
+    largeBodies.clear();
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t cells = entryOffsets[i];
+        if (cells == 0) largeBodies.push_back(i);
+        entryOffsets[i] = total;
+        total += cells;
+    }
+    entryOffsets[count] = total;
+
+    // 按前缀和的位置把每个物体放进它覆盖的所有格子
+    entries.resize(total);
+    forEachChunk(jobs, bodyChunks, [&](uint32_t chunk) {
+        for (uint32_t i = chunkBegin(count, bodyChunks, chunk); i < chunkBegin(count, bodyChunks, chunk + 1); i++) {
+            uint32_t out = entryOffsets[i];
+            if (out == entryOffsets[i + 1]) continue;
+
+            int x0, y0, x1, y1;
+            cellRange(i, x0, y0, x1, y1);
+            for (int y = y0; y <= y1; y++) {
+                for (int x = x0; x <= x1; x++) {
+                    entries[out++] = {packCell(x, y), i};
+                }
+            }
+        }
+    });
+
+    parallelSort(jobs, entries, scratchEntries, [](const CellEntry& lhs, const CellEntry& rhs) {
+        return lhs.cell != rhs.cell ? lhs.cell < rhs.cell : lhs.body < rhs.body;
+    });
+
+    runStarts.clear();
+    for (uint32_t e = 0; e < total; e++) {
+        if (e == 0 || entries[e].cell != entries[e - 1].cell) runStarts.push_back(e);
+    }
+    runStarts.push_back(total);
+    const uint32_t runCount = static_cast<uint32_t>(runStarts.size()) - 1;
+
+    // 同一格子内两两测试，只在交集左下角所在的格子里报告；每块格子写自己的输出
+    uint32_t runChunks = chunkCountFor(jobs, runCount, 256);
+    uint32_t largeChunks = largeBodies.empty() ? 0 : chunkCountFor(jobs, count, 4096);
+    uint32_t staticChunks = staticProxies.empty() ? 0 : chunkCountFor(jobs, count, 1024);
+    chunkPairs.resize(runChunks + largeChunks + staticChunks);
+    forEachChunk(jobs, runChunks, [&](uint32_t chunk) {
+        std::vector<BroadphasePair>& out = chunkPairs[chunk];
+        out.clear();
+        for (uint32_t run = chunkBegin(runCount, runChunks, chunk); run < chunkBegin(runCount, runChunks, chunk + 1); run++) {
+            uint32_t runStart = runStarts[run];
+            uint32_t runEnd = runStarts[run + 1];
+            for (uint32_t a = runStart; a < runEnd; a++) {
+                const AABB& boxA = bounds[entries[a].body];
+                for (uint32_t b = a + 1; b < runEnd; b++) {
+                    const AABB& boxB = bounds[entries[b].body];
+                    if (!boxA.overlaps(boxB)) continue;
+
+                    int cx = toCell(std::max(boxA.min.x, boxB.min.x), invSize);
+                    int cy = toCell(std::max(boxA.min.y, boxB.min.y), invSize);
+                    if (packCell(cx, cy) == entries[runStart].cell) {
+                        out.push_back(makePair(ids[entries[a].body], ids[entries[b].body]));
+                    }
+                }
+            }
+        }
+    });
+
+    // 超大物体直接和所有移动物体测试，按物体分块
+    forEachChunk(jobs, largeChunks, [&](uint32_t chunk) {
+        std::vector<BroadphasePair>& out = chunkPairs[runChunks + chunk];
+        out.clear();
+        uint32_t first = chunkBegin(count, largeChunks, chunk);
+        uint32_t last = chunkBegin(count, largeChunks, chunk + 1);
+        for (uint32_t large : largeBodies) {
+            size_t nextLarge = std::lower_bound(largeBodies.begin(), largeBodies.end(), first) - largeBodies.begin();
+            for (uint32_t i = first; i < last; i++) {
+                // 大物体之间只测试一次
+                while (nextLarge < largeBodies.size() && largeBodies[nextLarge] < i) nextLarge++;
+                bool otherIsLarge = nextLarge < largeBodies.size() && largeBodies[nextLarge] == i;
+                if (i == large || (otherIsLarge && i < large)) continue;
+
+                if (bounds[large].overlaps(bounds[i])) {
+                    out.push_back(makePair(ids[large], ids[i]));
+                }
+            }
+        }
+    });
+
+    // 每个移动物体去静态格子里查一遍
+    forEachChunk(jobs, staticChunks, [&](uint32_t chunk) {
+        std::vector<BroadphasePair>& out = chunkPairs[runChunks + largeChunks + chunk];
+        out.clear();
+        for (uint32_t i = chunkBegin(count, staticChunks, chunk); i < chunkBegin(count, staticChunks, chunk + 1); i++) {
+            queryStatic(bounds[i], ids[i], out);
+        }
+    });
+
+    concatenate(chunkPairs, pairs);
+    parallelSort(jobs, pairs, scratchPairs, pairLess);
+}
+
+void SpatialHashBroadphase::buildStaticGrid() {
+    // 静态集合变了才重建，格子大小按静态代理自己的平均尺寸
+    StaticGrid& grid = staticGrid;
+    grid.version = staticVersion;
+    grid.entries.clear();
+    grid.cells.clear();
+    grid.runStarts.clear();
+    grid.largeBodies.clear();
+    if (staticProxies.empty()) return;
+
+    float size = cellSize;
+    if (size <= 0.0f) {
+        double total = 0.0;
+        for (uint32_t id : staticProxies) total += maxExtent(proxyBoxes[id]);
+        size = autoCellSize(total, staticProxies.size());
+    }
+    grid.invSize = 1.0f / size;
+
+    for (uint32_t id : staticProxies) {
+        const AABB& box = proxyBoxes[id];
+        int x0 = toCell(box.min.x, grid.invSize);
+        int y0 = toCell(box.min.y, grid.invSize);
+        int x1 = toCell(box.max.x, grid.invSize);
+        int y1 = toCell(box.max.y, grid.invSize);
+        if (static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) > maxCellsPerBody) {
+            grid.largeBodies.push_back(id);
+            continue;
+        }
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                grid.entries.push_back({packCell(x, y), id});
+            }
+        }
+    }
+    std::sort(grid.entries.begin(), grid.entries.end(), [](const CellEntry& lhs, const CellEntry& rhs) {
+        return lhs.cell != rhs.cell ? lhs.cell < rhs.cell : lhs.body < rhs.body;
+    });
+
+    const uint32_t total = static_cast<uint32_t>(grid.entries.size());
+    for (uint32_t e = 0; e < total; e++) {
+        if (e == 0 || grid.entries[e].cell != grid.entries[e - 1].cell) {
+            grid.cells.push_back(grid.entries[e].cell);
+            grid.runStarts.push_back(e);
+        }
+    }
+    grid.runStarts.push_back(total);
+}
+
+void SpatialHashBroadphase::queryStatic(const AABB& box, uint32_t id, std::vector<BroadphasePair>& out) const {
+    const StaticGrid& grid = staticGrid;
+    int x0 = toCell(box.min.x, grid.invSize);
+    int y0 = toCell(box.min.y, grid.invSize);
+    int x1 = toCell(box.max.x, grid.invSize);
+    int y1 = toCell(box.max.y, grid.invSize);
+
+    // 移动物体太大时直接测试所有静态代理
+    if (static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) > maxCellsPerBody) {
+        for (uint32_t other : staticProxies) {
+            if (box.overlaps(proxyBoxes[other])) out.push_back(makePair(id, other));
+        }
+        return;
+    }
+
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            uint64_t cell = packCell(x, y);
+            auto it = std::lower_bound(grid.cells.begin(), grid.cells.end(), cell);
+            if (it == grid.cells.end() || *it != cell) continue;
+
+            size_t run = it - grid.cells.begin();
+            for (uint32_t e = grid.runStarts[run]; e < grid.runStarts[run + 1]; e++) {
+                const AABB& other = proxyBoxes[grid.entries[e].body];
+                if (!box.overlaps(other)) continue;
+
+                // 同样只在交集左下角所在的格子里报告
+                int cx = toCell(std::max(box.min.x, other.min.x), grid.invSize);
+                int cy = toCell(std::max(box.min.y, other.min.y), grid.invSize);
+                if (packCell(cx, cy) == cell) {
+                    out.push_back(makePair(id, grid.entries[e].body));
+                }
+            }
+        }
+    }
+
+    for (uint32_t other : grid.largeBodies) {
+        if (box.overlaps(proxyBoxes[other])) out.push_back(makePair(id, other));
+    }
+}
+
+// SweepAndPruneBroadphase 实现
+namespace {
+
+// 超过这个数量的新代理不再逐个插入，整体重建
+const size_t maxIncrementalInserts = 16;
+
+// 数值相同时 min 排在 max 前面，和 AABB::overlaps 的“接触也算重叠”一致
+bool endpointLess(float valueA, uint32_t dataA, float valueB, uint32_t dataB) {
+    return valueA < valueB || (valueA == valueB && (dataA & 1u) < (dataB & 1u));
+}
+
+} // namespace
+
+void SweepAndPruneBroadphase::reset() {
+    Broadphase::reset();
+    axes[0].clear();
+    axes[1].clear();
+    pairKeys.clear();
+    createdProxies.clear();
+    destroyed.clear();
+    destroyedCount = 0;
+}
+
+void SweepAndPruneBroadphase::createProxy(uint32_t id, const AABB& box, bool moving) {
+    // 编号被重新使用前，先把旧代理的端点清掉
+    if (id < destroyed.size() && destroyed[id]) dropDestroyed();
+    Broadphase::createProxy(id, box, moving);
+    createdProxies.push_back(id);
+}
+
+void SweepAndPruneBroadphase::destroyProxy(uint32_t id) {
+    Broadphase::destroyProxy(id);
+    auto created = std::find(createdProxies.begin(), createdProxies.end(), id);
+    if (created != createdProxies.end()) {
+        // 还没进端点数组，直接丢掉
+        createdProxies.erase(created);
+        return;
+    }
+    if (id >= destroyed.size()) destroyed.resize(id + 1, 0);
+    destroyed[id] = 1;
+    destroyedCount++;
+}
+
+void SweepAndPruneBroadphase::updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                                          std::vector<BroadphasePair>& pairs) {
+    addedKeys.clear();
+    removedKeys.clear();
+    droppedKeys.clear();
+    swapCount = 0;
+    dropDestroyed();
+
+    // 只刷新移动代理的包围盒，静态端点的值保持不变
+    for (uint32_t i = 0; i < movingCount; i++) {
+        proxyBoxes[ids[i]] = bounds[i];
+    }
+
+    if (createdProxies.size() > maxIncrementalInserts || axes[0].empty()) {
+        // 一次加入很多代理时整体重建
+        rebuild();
+    } else {
+        // 少量新代理的端点追加到末尾，由插入排序放到位置上并检测出重叠
+        for (int axis = 0; axis < 2; axis++) {
+            for (uint32_t id : createdProxies) {
+                axes[axis].push_back({0.0f, id << 1});
+                axes[axis].push_back({0.0f, (id << 1) | 1u});
+            }
+        }
+        sortAxis(0);
+        sortAxis(1);
+        applyPairChanges();
+    }
+    createdProxies.clear();
+
+    if (!droppedKeys.empty()) {
+        removedKeys.insert(removedKeys.end(), droppedKeys.begin(), droppedKeys.end());
+        std::sort(removedKeys.begin(), removedKeys.end());
+    }
+    keysToPairs(addedKeys, addedPairs);
+    keysToPairs(removedKeys, removedPairs);
+
+    // 两个都是静态代理的对不输出
+    pairs.clear();
+    for (uint64_t key : pairKeys) {
+        BroadphasePair pair = keyToPair(key);
+        if (!isStatic(pair.a) || !isStatic(pair.b)) pairs.push_back(pair);
+    }
+}
+
+void SweepAndPruneBroadphase::dropDestroyed() {
+    if (destroyedCount == 0) return;
+
+    auto isDestroyed = [this](uint32_t id) { return id < destroyed.size() && destroyed[id]; };
+    for (int axis = 0; axis < 2; axis++) {
+        std::vector<Endpoint>& endpoints = axes[axis];
+        endpoints.erase(std::remove_if(endpoints.begin(), endpoints.end(), [&](const Endpoint& endpoint) {
+            return isDestroyed(endpoint.data >> 1);
+        }), endpoints.end());
+    }
+
+    // 删掉的代理的对算作移除
+    scratchKeys.clear();
+    for (uint64_t key : pairKeys) {
+        BroadphasePair pair = keyToPair(key);
+        if (isDestroyed(pair.a) || isDestroyed(pair.b)) {
+            droppedKeys.push_back(key);
+        } else {
+            scratchKeys.push_back(key);
+        }
+    }
+    pairKeys.swap(scratchKeys);
+
+    std::fill(destroyed.begin(), destroyed.end(), 0);
+    destroyedCount = 0;
+}
+
+void SweepAndPruneBroadphase::sortAxis(int axis) {
+    std::vector<Endpoint>& endpoints = axes[axis];
+
+    // 先刷新端点值，再用插入排序恢复有序（相邻帧几乎有序）
+    for (auto& endpoint : endpoints) {
+        const AABB& box = proxyBoxes[endpoint.data >> 1];
+        endpoint.value = (endpoint.data & 1u) ? box.max[axis] : box.min[axis];
+    }
+
+    for (size_t i = 1; i < endpoints.size(); i++) {
+        Endpoint key = endpoints[i];
+        uint32_t keyBody = key.data >> 1;
+        bool keyIsMax = (key.data & 1u) != 0;
+
+        size_t j = i;
+        while (j > 0 && endpointLess(key.value, key.data, endpoints[j - 1].value, endpoints[j - 1].data)) {
+            const Endpoint& prev = endpoints[j - 1];
+            uint32_t prevBody = prev.data >> 1;
+            bool prevIsMax = (prev.data & 1u) != 0;
+
+            if (!keyIsMax && prevIsMax) {
+                // min 越过 max：这一轴开始重叠，检查完整包围盒
+                if (proxyBoxes[keyBody].overlaps(proxyBoxes[prevBody])) {
+                    addedKeys.push_back(pairKey(keyBody, prevBody));
+                }
+            } else if (keyIsMax && !prevIsMax) {
+                // max 越过 min：这一轴分离
+                removedKeys.push_back(pairKey(keyBody, prevBody));
+            }
+
+            endpoints[j] = prev;
+            j--;
+            swapCount++;
+        }
+        endpoints[j] = key;
+    }
+}
+
+void SweepAndPruneBroadphase::applyPairChanges() {
+    // 只保留真正改变了状态的对
+    std::sort(addedKeys.begin(), addedKeys.end());
+    addedKeys.erase(std::unique(addedKeys.begin(), addedKeys.end()), addedKeys.end());
+    addedKeys.erase(std::remove_if(addedKeys.begin(), addedKeys.end(), [this](uint64_t key) {
+        return std::binary_search(pairKeys.begin(), pairKeys.end(), key);
+    }), addedKeys.end());
+
+    std::sort(removedKeys.begin(), removedKeys.end());
+    removedKeys.erase(std::unique(removedKeys.begin(), removedKeys.end()), removedKeys.end());
+    removedKeys.erase(std::remove_if(removedKeys.begin(), removedKeys.end(), [this](uint64_t key) {
+        return !std::binary_search(pairKeys.begin(), pairKeys.end(), key);
+    }), removedKeys.end());
+
+    if (addedKeys.empty() && removedKeys.empty()) return;
+
+    scratchKeys.clear();
+    std::set_difference(pairKeys.begin(), pairKeys.end(), removedKeys.begin(), removedKeys.end(),
+                        std::back_inserter(scratchKeys));
+    pairKeys.clear();
+    std::merge(scratchKeys.begin(), scratchKeys.end(), addedKeys.begin(), addedKeys.end(),
+               std::back_inserter(pairKeys));
+}
+
+void SweepAndPruneBroadphase::rebuild() {
+    for (int axis = 0; axis < 2; axis++) {
+        std::vector<Endpoint>& endpoints = axes[axis];
+        endpoints.clear();
+        for (uint32_t id = 0; id < proxyStates.size(); id++) {
+            if (proxyStates[id] == ProxyState::None) continue;
+            endpoints.push_back({proxyBoxes[id].min[axis], id << 1});
+            endpoints.push_back({proxyBoxes[id].max[axis], (id << 1) | 1u});
+        }
+        std::sort(endpoints.begin(), endpoints.end(), [](const Endpoint& lhs, const Endpoint& rhs) {
+            return endpointLess(lhs.value, lhs.data, rhs.value, rhs.data);
+        });
+    }
+
+    // 沿 x 轴扫描一次得到全部重叠对
+    scratchKeys.clear();
+    std::vector<uint32_t> active;
+    for (const auto& endpoint : axes[0]) {
+        uint32_t body = endpoint.data >> 1;
+        if (endpoint.data & 1u) {
+            active.erase(std::find(active.begin(), active.end(), body));
+            continue;
+        }
+        for (uint32_t other : active) {
+            if (proxyBoxes[body].overlaps(proxyBoxes[other])) {
+                scratchKeys.push_back(pairKey(body, other));
+            }
+        }
+        active.push_back(body);
+    }
+    std::sort(scratchKeys.begin(), scratchKeys.end());
+
+    // 重建前后的差异作为增量
+    std::set_difference(scratchKeys.begin(), scratchKeys.end(), pairKeys.begin(), pairKeys.end(),
+                        std::back_inserter(addedKeys));
+    std::set_difference(pairKeys.begin(), pairKeys.end(), scratchKeys.begin(), scratchKeys.end(),
+                        std::back_inserter(removedKeys));
+    pairKeys.swap(scratchKeys);
+}
+
+// DynamicTreeBroadphase 实现
+void DynamicTreeBroadphase::reset() {
+    Broadphase::reset();
+    tree.clear();
+    treeProxies.clear();
+    moved.clear();
+    touchedProxies.clear();
+    destroyed.clear();
+    destroyedCount = 0;
+    fatPairKeys.clear();
+}
+
+void DynamicTreeBroadphase::createProxy(uint32_t id, const AABB& box, bool moving) {
+    // 编号被重新使用前，先把旧代理的对清掉
+    if (id < destroyed.size() && destroyed[id]) dropDestroyed();
+    Broadphase::createProxy(id, box, moving);
+    if (id >= treeProxies.size()) {
+        treeProxies.resize(id + 1, DynamicAABBTree::nullNode);
+        moved.resize(id + 1, 0);
+        destroyed.resize(id + 1, 0);
+    }
+    treeProxies[id] = tree.createProxy(box, id);
+    touchedProxies.push_back(id);
+}
+
+void DynamicTreeBroadphase::destroyProxy(uint32_t id) {
+    Broadphase::destroyProxy(id);
+    tree.destroyProxy(treeProxies[id]);
+    treeProxies[id] = DynamicAABBTree::nullNode;
+    destroyed[id] = 1;
+    destroyedCount++;
+}
+
+void DynamicTreeBroadphase::setProxyMoving(uint32_t id, bool moving, const AABB& box) {
+    bool wasMoving = proxyStates[id] == ProxyState::Moving;
+    Broadphase::setProxyMoving(id, moving, box);
+    if (moving) {
+        // 静态代理之间的对没有保留，重新开始移动时要重新查询
+        if (!wasMoving) touchedProxies.push_back(id);
+    } else if (tree.moveProxy(treeProxies[id], box)) {
+        // 变成静态时按最终的包围盒放好，之后不再移动
+        touchedProxies.push_back(id);
+    }
+}
+
+void DynamicTreeBroadphase::updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                                        std::vector<BroadphasePair>& pairs) {
+    dropDestroyed();
+    movedBodies.clear();
+
+    // 新建和刚变成静态的代理也要重新查询
+    for (uint32_t id : touchedProxies) {
+        if (proxyStates[id] != ProxyState::None && !moved[id]) {
+            moved[id] = 1;
+            movedBodies.push_back(id);
+        }
+    }
+    touchedProxies.clear();
+
+    // 只有离开胖包围盒的移动代理才需要更新，静态代理不碰
+    for (uint32_t i = 0; i < movingCount; i++) {
+        uint32_t id = ids[i];
+        proxyBoxes[id] = bounds[i];
+        if (tree.moveProxy(treeProxies[id], bounds[i]) && !moved[id]) {
+            moved[id] = 1;
+            movedBodies.push_back(id);
+        }
+    }
+
+    // 两个代理都没动的对，胖包围盒没变，直接保留；两个都是静态的丢掉
+    scratchKeys.clear();
+    for (uint64_t key : fatPairKeys) {
+        BroadphasePair pair = keyToPair(key);
+        if (!moved[pair.a] && !moved[pair.b] && !(isStatic(pair.a) && isStatic(pair.b))) {
+            scratchKeys.push_back(key);
+        }
+    }
+
+    // 移动过的代理重新查询树
+    newKeys.clear();
+    for (uint32_t body : movedBodies) {
+        tree.query(tree.getFatAABB(treeProxies[body]), [&](int proxyId) {
+            uint32_t other = tree.getUserData(proxyId);
+            // 两个都移动过时只由编号小的一方记录，静态代理之间不记录
+            if (other != body && (!moved[other] || body < other) && !(isStatic(body) && isStatic(other))) {
+                newKeys.push_back(pairKey(body, other));
+            }
+            return true;
+        });
+    }
+    std::sort(newKeys.begin(), newKeys.end());
+
+    fatPairKeys.clear();
+    std::merge(scratchKeys.begin(), scratchKeys.end(), newKeys.begin(), newKeys.end(),
+               std::back_inserter(fatPairKeys));
+    for (uint32_t body : movedBodies) moved[body] = 0;
+
+    // 输出真实包围盒重叠的对
+    pairs.clear();
+    for (uint64_t key : fatPairKeys) {
+        BroadphasePair pair = keyToPair(key);
+        if (proxyBoxes[pair.a].overlaps(proxyBoxes[pair.b])) {
+            pairs.push_back(pair);
+        }
+    }
+}
+
+void DynamicTreeBroadphase::dropDestroyed() {
+    if (destroyedCount == 0) return;
+
+    fatPairKeys.erase(std::remove_if(fatPairKeys.begin(), fatPairKeys.end(), [this](uint64_t key) {
+        BroadphasePair pair = keyToPair(key);
+        return destroyed[pair.a] || destroyed[pair.b];
+    }), fatPairKeys.end());
+    std::fill(destroyed.begin(), destroyed.end(), 0);
+    destroyedCount = 0;
+}
+
+void DynamicTreeBroadphase::queryRegion(const AABB& region, std::vector<uint32_t>& bodies) const {
+    bodies.clear();
+    tree.query(region, [&](int proxyId) {
+        uint32_t body = tree.getUserData(proxyId);
+        if (proxyBoxes[body].overlaps(region)) {
+            bodies.push_back(body);
+        }
+        return true;
+    });
+    std::sort(bodies.begin(), bodies.end());
+}
+
+bool DynamicTreeBroadphase::rayCast(const glm::vec2& p1, const glm::vec2& p2, uint32_t& body, float& fraction) const {
+    bool found = false;
+    glm::vec2 d = p2 - p1;
+
+    DynamicAABBTree::RayCastInput input = {p1, p2, 1.0f};
+    tree.rayCast(input, [&](const DynamicAABBTree::RayCastInput& subInput, int proxyId) {
+        // 对真实包围盒做 slab 测试
+        uint32_t candidate = tree.getUserData(proxyId);
+        const AABB& box = proxyBoxes[candidate];
+        float tMin = 0.0f;
+        float tMax = subInput.maxFraction;
+        for (int axis = 0; axis < 2; axis++) {
+            if (std::abs(d[axis]) < 1e-12f) {
+                if (p1[axis] < box.min[axis] || p1[axis] > box.max[axis]) return -1.0f;
+            } else {
+                float invD = 1.0f / d[axis];
+                float t1 = (box.min[axis] - p1[axis]) * invD;
+                float t2 = (box.max[axis] - p1[axis]) * invD;
+                tMin = std::max(tMin, std::min(t1, t2));
+                tMax = std::min(tMax, std::max(t1, t2));
+                if (tMin > tMax) return -1.0f;
+            }
+        }
+
+        found = true;
+        body = candidate;
+        fraction = tMin;
+        // 起点在包围盒内时已经是最近的命中
+        return tMin;
+    });
+    return found;
+}
@@ -0,0 +1,228 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "AABB.h"
+#include "DynamicAABBTree.h"
+
+class JobSystem;
+
+// Candidate collision pair, proxy ids (a < b)
+struct BroadphasePair {
+    uint32_t a;
+    uint32_t b;
+};
+
+enum class BroadphaseType {
+    BruteForce,
+    SpatialHash,
+    SweepAndPrune,
+    DynamicTree
+};
+
+// Broadphase stage: turns body AABBs into candidate pairs for the narrowphase.
+// Every body owns a proxy keyed by a stable id chosen by the caller (the engine uses handle slots),
+// so reordering the body rows never touches the broadphase. Moving proxies take their box from the
+// bounds passed to updatePairs; static proxies (sleeping bodies) keep the box they were given and
+// are only tested against moving ones, so two static proxies never form a pair.
+// Pairs are reported as proxy ids sorted by (a, b).
+class Broadphase {
+public:
+    virtual ~Broadphase() = default;
+
+    virtual BroadphaseType getType() const = 0;
+
+    virtual void createProxy(uint32_t id, const AABB& box, bool moving);
+    virtual void destroyProxy(uint32_t id);
+    // A proxy turning static keeps box until it moves again
+    virtual void setProxyMoving(uint32_t id, bool moving, const AABB& box);
+    // bounds[i] is the box of proxy ids[i] for i < movingCount, which must list exactly the moving proxies
+    virtual void updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                             std::vector<BroadphasePair>& pairs) = 0;
+    // Drops every proxy
+    virtual void reset();
+
+    // Stateless form: every box is a moving proxy whose id is its index, so pairs are indices into
+    // bounds. The proxies are rebuilt when the count changes; not to be mixed with the calls above.
+    void computePairs(const std::vector<AABB>& bounds, std::vector<BroadphasePair>& pairs);
+
+    // Worker pool for the broadphases that can split their work; null runs everything serially
+    void setJobSystem(JobSystem* system) { jobs = system; }
+
+protected:
+    enum class ProxyState : uint8_t {
+        None,
+        Moving,
+        Static
+    };
+
+    JobSystem* jobs = nullptr;
+    std::vector<ProxyState> proxyStates;   // by proxy id
+    std::vector<AABB> proxyBoxes;          // by proxy id; the static boxes, and moving ones where a broadphase keeps them
+    std::vector<uint32_t> staticProxies;   // ids of the static proxies, unordered
+    uint64_t staticVersion = 0;            // bumped whenever the static set changes
+
+    bool isStatic(uint32_t id) const { return proxyStates[id] == ProxyState::Static; }
+
+private:
+    std::vector<uint32_t> staticSlots;     // proxy id -> position in staticProxies
+    std::vector<uint32_t> indexIds;        // identity ids for computePairs
+
+    void addStatic(uint32_t id);
+    void removeStatic(uint32_t id);
+};
+
+std::unique_ptr<Broadphase> createBroadphase(BroadphaseType type);
+
+// Tests every pair, O(n²). Kept as the reference path.
+class BruteForceBroadphase : public Broadphase {
+public:
+    BroadphaseType getType() const override { return BroadphaseType::BruteForce; }
+    void updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                     std::vector<BroadphasePair>& pairs) override;
+
+private:
+    std::vector<std::vector<BroadphasePair>> chunkPairs;
+    std::vector<BroadphasePair> scratchPairs;
+};
+
+// Uniform grid keyed by integer cell coordinates. Each body is binned into every cell its AABB
+// touches, and a pair is only reported from the cell holding the min corner of the two boxes'
+// intersection, so no pair is emitted twice. The moving proxies are binned every step; the static
+// ones sit in a second grid that is only rebuilt when the static set changes, and each moving box
+// looks up the static cells it covers. With a job system the binning, the per-cell tests and the
+// sorts are split into chunks; the result does not depend on the thread count.
+class SpatialHashBroadphase : public Broadphase {
+public:
+    // cellSize <= 0 picks the cell size from the average body extent every step
+    explicit SpatialHashBroadphase(float cellSize = 0.0f);
+
+    BroadphaseType getType() const override { return BroadphaseType::SpatialHash; }
+    void updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                     std::vector<BroadphasePair>& pairs) override;
+
+    void setCellSize(float size) { cellSize = size; staticGrid.version = ~0ull; }
+    float getCellSize() const { return cellSize; }
+    // Bodies touching more cells than this are tested against everything instead
+    void setMaxCellsPerBody(int count) { maxCellsPerBody = count; staticGrid.version = ~0ull; }
+
+private:
+    struct CellEntry {
+        uint64_t cell;
+        uint32_t body;
+    };
+
+    // Static proxies binned by cell; body is the proxy id
+    struct StaticGrid {
+        float invSize = 1.0f;
+        std::vector<CellEntry> entries;
+        std::vector<uint64_t> cells;        // distinct cells, sorted
+        std::vector<uint32_t> runStarts;    // first entry of each cell
+        std::vector<uint32_t> largeBodies;  // proxies touching too many cells
+        uint64_t version = ~0ull;           // staticVersion it was built for
+    };
+
+    float cellSize;
+    int maxCellsPerBody;
+    std::vector<CellEntry> entries;
+    std::vector<CellEntry> scratchEntries;
+    std::vector<uint32_t> entryOffsets;   // first entry of each body, prefix sum of the cell counts
+    std::vector<uint32_t> runStarts;      // first entry of each cell
+    std::vector<uint32_t> largeBodies;
+    StaticGrid staticGrid;
+    std::vector<std::vector<BroadphasePair>> chunkPairs;
+    std::vector<BroadphasePair> scratchPairs;
+
+    void buildStaticGrid();
+    void queryStatic(const AABB& box, uint32_t id, std::vector<BroadphasePair>& out) const;
+};
+
+// Sort-and-sweep over both axes. Endpoint arrays stay sorted between steps and are re-sorted with
+// insertion sort, so a step costs O(n + swaps) when bodies barely move. Overlap changes are
+// detected from the swaps themselves and reported as pair add/remove deltas. Static endpoints keep
+// their values, new proxies are sorted in from the end of the arrays (or trigger a rebuild when
+// many arrive at once) and destroyed ones are dropped before the next sort.
+class SweepAndPruneBroadphase : public Broadphase {
+public:
+    BroadphaseType getType() const override { return BroadphaseType::SweepAndPrune; }
+    void createProxy(uint32_t id, const AABB& box, bool moving) override;
+    void destroyProxy(uint32_t id) override;
+    void updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                     std::vector<BroadphasePair>& pairs) override;
+    void reset() override;
+
+    // Pair changes produced by the last updatePairs call, static pairs included
+    const std::vector<BroadphasePair>& getAddedPairs() const { return addedPairs; }
+    const std::vector<BroadphasePair>& getRemovedPairs() const { return removedPairs; }
+    // Endpoint swaps done by the last insertion sort
+    size_t getLastSwapCount() const { return swapCount; }
+
+private:
+    struct Endpoint {
+        float value;
+        uint32_t data; // proxy id << 1 | isMax
+    };
+
+    std::vector<Endpoint> axes[2];
+    size_t swapCount = 0;
+    std::vector<uint32_t> createdProxies;    // not in the endpoint arrays yet
+    std::vector<char> destroyed;             // by proxy id, still in the arrays
+    size_t destroyedCount = 0;
+
+    // Current overlapping pairs, packed as (a << 32 | b) and kept sorted
+    std::vector<uint64_t> pairKeys;
+    std::vector<uint64_t> addedKeys;
+    std::vector<uint64_t> removedKeys;
+    std::vector<uint64_t> droppedKeys;       // pairs of destroyed proxies
+    std::vector<uint64_t> scratchKeys;
+    std::vector<BroadphasePair> addedPairs;
+    std::vector<BroadphasePair> removedPairs;
+
+    void dropDestroyed();
+    void rebuild();
+    void sortAxis(int axis);
+    void applyPairChanges();
+};
+
+// Dynamic AABB tree over fattened body boxes. A body only touches the tree when its box leaves
+// the fat box, and only those bodies are re-queried for new pairs; pairs between resting bodies
+// are carried over from the previous step. Static proxies are never moved and pairs between two of
+// them are not kept, so a proxy that starts moving again is re-queried. Also serves region and ray
+// queries.
+class DynamicTreeBroadphase : public Broadphase {
+public:
+    BroadphaseType getType() const override { return BroadphaseType::DynamicTree; }
+    void createProxy(uint32_t id, const AABB& box, bool moving) override;
+    void destroyProxy(uint32_t id) override;
+    void setProxyMoving(uint32_t id, bool moving, const AABB& box) override;
+    void updatePairs(const std::vector<AABB>& bounds, const std::vector<uint32_t>& ids, uint32_t movingCount,
+                     std::vector<BroadphasePair>& pairs) override;
+    void reset() override;
+
+    // Proxy ids (as of the last updatePairs) whose box overlaps the region
+    void queryRegion(const AABB& region, std::vector<uint32_t>& bodies) const;
+    // Closest proxy whose box the segment p1 -> p2 hits; fraction is along the segment
+    bool rayCast(const glm::vec2& p1, const glm::vec2& p2, uint32_t& body, float& fraction) const;
+
+    DynamicAABBTree& getTree() { return tree; }
+    const DynamicAABBTree& getTree() const { return tree; }
+    // Proxies whose fat box changed in the last step
+    size_t getLastMovedCount() const { return movedBodies.size(); }
+
+private:
+    DynamicAABBTree tree;
+    std::vector<int> treeProxies;      // proxy id -> tree proxy
+    std::vector<char> moved;           // by proxy id
+    std::vector<uint32_t> movedBodies;
+    std::vector<uint32_t> touchedProxies;  // created or frozen since the last update
+    std::vector<char> destroyed;       // by proxy id, pairs not dropped yet
+    size_t destroyedCount = 0;
+
+    // Pairs whose fat boxes overlap, packed as (a << 32 | b) and kept sorted
+    std::vector<uint64_t> fatPairKeys;
+    std::vector<uint64_t> newKeys;
+    std::vector<uint64_t> scratchKeys;
+
+    void dropDestroyed();
+};
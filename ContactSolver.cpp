@@ -0,0 +1,469 @@
+#include "ContactSolver.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SOLVER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#define SOLVER_TARGET(isa)
+#else
+#define SOLVER_TARGET(isa) __attribute__((target(isa)))
+#endif
+#else
+#define SOLVER_X86 0
+#endif
+
+namespace {
+
+// 每步消除超出容差部分穿透的比例
+constexpr float baumgarteFactor = 0.2f;
+// 允许的穿透，留一点重叠让接触在相邻两步之间保持
+constexpr float penetrationSlop = 0.0005f;
+// 地面约束的键：b 用一个不会是物体 id 的值
+constexpr uint64_t groundKey = ~0ull;
+
+constexpr uint32_t invalidConstraint = 0xFFFFFFFFu;
+// 每个颜色最多用到的位数，超出的约束放进最后串行求解的颜色
+constexpr uint32_t maxParallelColors = 64;
+// 每个任务处理的批数
+constexpr uint32_t batchGrainSize = 64;
+
+using Batch = ContactSolver::ConstraintBatch;
+constexpr uint32_t lanes = ContactSolver::laneCount;
+
+// 与 _mm_min_ps / _mm_max_ps 相同的比较方式，标量和向量版本的结果才能逐位一致
+inline float laneMin(float a, float b) { return a < b ? a : b; }
+inline float laneMax(float a, float b) { return a > b ? a : b; }
+
+// 标量版本，也是向量版本的参考实现：先摩擦，再法向
+void solveVelocityScalar(Batch& batch, glm::vec2* velocities, const float* inverseMasses) {
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        uint32_t a = batch.a[lane], b = batch.b[lane];
+        float vax = velocities[a].x, vay = velocities[a].y;
+        float vbx = velocities[b].x, vby = velocities[b].y;
+        float ima = inverseMasses[a], imb = inverseMasses[b];
+        float nx = batch.normalX[lane], ny = batch.normalY[lane];
+        float tx = -ny, ty = nx;
+
+        // 摩擦：切向冲量限制在摩擦锥内
+        float vt = (vbx - vax) * tx + (vby - vay) * ty;
+        float maxFriction = batch.friction[lane] * batch.normalImpulse[lane];
+        float tangentImpulse = laneMin(laneMax(batch.tangentImpulse[lane] - batch.mass[lane] * vt, -maxFriction), maxFriction);
+        float delta = tangentImpulse - batch.tangentImpulse[lane];
+        batch.tangentImpulse[lane] = tangentImpulse;
+        vax -= tx * delta * ima;
+        vay -= ty * delta * ima;
+        vbx += tx * delta * imb;
+        vby += ty * delta * imb;
+
+        // 法向：累积冲量只能推开
+        float vn = (vbx - vax) * nx + (vby - vay) * ny;
+        float normalImpulse = laneMax(batch.normalImpulse[lane] + batch.mass[lane] * (batch.bias[lane] - vn), 0.0f);
+        delta = normalImpulse - batch.normalImpulse[lane];
+        batch.normalImpulse[lane] = normalImpulse;
+        vax -= nx * delta * ima;
+        vay -= ny * delta * ima;
+        vbx += nx * delta * imb;
+        vby += ny * delta * imb;
+
+        // 静态物体不写，同一颜色的其他批也会读它
+        if (ima != 0.0f) velocities[a] = glm::vec2(vax, vay);
+        if (imb != 0.0f) velocities[b] = glm::vec2(vbx, vby);
+    }
+}
+
+// 伪速度只修正用求解后的速度走完这一步还剩下的穿透。
+// 只读速度、只写本批，标量和向量求解共用，结果不受指令集影响
+void updatePositionBias(Batch& batch, const glm::vec2* velocities) {
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        uint32_t a = batch.a[lane], b = batch.b[lane];
+        float vn = (velocities[b].x - velocities[a].x) * batch.normalX[lane] + (velocities[b].y - velocities[a].y) * batch.normalY[lane];
+        batch.positionBias[lane] = laneMax(batch.positionBias[lane] - baumgarteFactor * vn, 0.0f);
+    }
+}
+
+// 法向伪冲量，只用于分开重叠的物体，不留在速度里
+void solvePositionScalar(Batch& batch, glm::vec2* pseudoVelocities, const float* inverseMasses) {
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        uint32_t a = batch.a[lane], b = batch.b[lane];
+        float nx = batch.normalX[lane], ny = batch.normalY[lane];
+        float ima = inverseMasses[a], imb = inverseMasses[b];
+
+        float vn = (pseudoVelocities[b].x - pseudoVelocities[a].x) * nx + (pseudoVelocities[b].y - pseudoVelocities[a].y) * ny;
+        float positionImpulse = laneMax(batch.positionImpulse[lane] + batch.mass[lane] * (batch.positionBias[lane] - vn), 0.0f);
+        float delta = positionImpulse - batch.positionImpulse[lane];
+        batch.positionImpulse[lane] = positionImpulse;
+
+        if (ima != 0.0f) pseudoVelocities[a] -= glm::vec2(nx * delta * ima, ny * delta * ima);
+        if (imb != 0.0f) pseudoVelocities[b] += glm::vec2(nx * delta * imb, ny * delta * imb);
+    }
+}
+
+#if SOLVER_X86
+
+// 4 个约束各占一个通道：按下标取出两个物体的速度，算完再逐个写回
+struct LaneBodies {
+    __m128 ax, ay, bx, by, ima, imb;
+};
+
+SOLVER_TARGET("sse4.1")
+inline LaneBodies gatherBodies(const Batch& batch, const glm::vec2* velocities, const float* inverseMasses) {
+    const uint32_t* a = batch.a;
+    const uint32_t* b = batch.b;
+    return {
+        _mm_setr_ps(velocities[a[0]].x, velocities[a[1]].x, velocities[a[2]].x, velocities[a[3]].x),
+        _mm_setr_ps(velocities[a[0]].y, velocities[a[1]].y, velocities[a[2]].y, velocities[a[3]].y),
+        _mm_setr_ps(velocities[b[0]].x, velocities[b[1]].x, velocities[b[2]].x, velocities[b[3]].x),
+        _mm_setr_ps(velocities[b[0]].y, velocities[b[1]].y, velocities[b[2]].y, velocities[b[3]].y),
+        _mm_setr_ps(inverseMasses[a[0]], inverseMasses[a[1]], inverseMasses[a[2]], inverseMasses[a[3]]),
+        _mm_setr_ps(inverseMasses[b[0]], inverseMasses[b[1]], inverseMasses[b[2]], inverseMasses[b[3]]),
+    };
+}
+
+SOLVER_TARGET("sse4.1")
+inline void scatterBodies(const Batch& batch, const LaneBodies& lanesIn, glm::vec2* velocities) {
+    alignas(16) float ax[4], ay[4], bx[4], by[4], ima[4], imb[4];
+    _mm_store_ps(ax, lanesIn.ax);
+    _mm_store_ps(ay, lanesIn.ay);
+    _mm_store_ps(bx, lanesIn.bx);
+    _mm_store_ps(by, lanesIn.by);
+    _mm_store_ps(ima, lanesIn.ima);
+    _mm_store_ps(imb, lanesIn.imb);
+    for (uint32_t lane = 0; lane < lanes; lane++) {
+        if (ima[lane] != 0.0f) velocities[batch.a[lane]] = glm::vec2(ax[lane], ay[lane]);
+        if (imb[lane] != 0.0f) velocities[batch.b[lane]] = glm::vec2(bx[lane], by[lane]);
+    }
+}
+
+// 和标量版本相同的运算和顺序
+SOLVER_TARGET("sse4.1")
+void solveVelocitySSE4(Batch& batch, glm::vec2* velocities, const float* inverseMasses) {
+    LaneBodies v = gatherBodies(batch, velocities, inverseMasses);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 nx = _mm_loadu_ps(batch.normalX), ny = _mm_loadu_ps(batch.normalY);
+    __m128 tx = _mm_xor_ps(ny, signBit), ty = nx;
+    __m128 mass = _mm_loadu_ps(batch.mass);
+
+    // 摩擦
+    __m128 vt = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(v.bx, v.ax), tx), _mm_mul_ps(_mm_sub_ps(v.by, v.ay), ty));
+    __m128 maxFriction = _mm_mul_ps(_mm_loadu_ps(batch.friction), _mm_loadu_ps(batch.normalImpulse));
+    __m128 oldTangent = _mm_loadu_ps(batch.tangentImpulse);
+    __m128 tangent = _mm_sub_ps(oldTangent, _mm_mul_ps(mass, vt));
+    tangent = _mm_min_ps(_mm_max_ps(tangent, _mm_xor_ps(maxFriction, signBit)), maxFriction);
+    __m128 delta = _mm_sub_ps(tangent, oldTangent);
+    _mm_storeu_ps(batch.tangentImpulse, tangent);
+    v.ax = _mm_sub_ps(v.ax, _mm_mul_ps(_mm_mul_ps(tx, delta), v.ima));
+    v.ay = _mm_sub_ps(v.ay, _mm_mul_ps(_mm_mul_ps(ty, delta), v.ima));
+    v.bx = _mm_add_ps(v.bx, _mm_mul_ps(_mm_mul_ps(tx, delta), v.imb));
+    v.by = _mm_add_ps(v.by, _mm_mul_ps(_mm_mul_ps(ty, delta), v.imb));
+
+    // 法向
+    __m128 vn = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(v.bx, v.ax), nx), _mm_mul_ps(_mm_sub_ps(v.by, v.ay), ny));
+    __m128 oldNormal = _mm_loadu_ps(batch.normalImpulse);
+    __m128 normal = _mm_add_ps(oldNormal, _mm_mul_ps(mass, _mm_sub_ps(_mm_loadu_ps(batch.bias), vn)));
+    normal = _mm_max_ps(normal, zero);
+    delta = _mm_sub_ps(normal, oldNormal);
+    _mm_storeu_ps(batch.normalImpulse, normal);
+    v.ax = _mm_sub_ps(v.ax, _mm_mul_ps(_mm_mul_ps(nx, delta), v.ima));
+    v.ay = _mm_sub_ps(v.ay, _mm_mul_ps(_mm_mul_ps(ny, delta), v.ima));
+    v.bx = _mm_add_ps(v.bx, _mm_mul_ps(_mm_mul_ps(nx, delta), v.imb));
+    v.by = _mm_add_ps(v.by, _mm_mul_ps(_mm_mul_ps(ny, delta), v.imb));
+
+    scatterBodies(batch, v, velocities);
+}
+
+SOLVER_TARGET("sse4.1")
+void solvePositionSSE4(Batch& batch, glm::vec2* pseudoVelocities, const float* inverseMasses) {
+    LaneBodies v = gatherBodies(batch, pseudoVelocities, inverseMasses);
+    __m128 nx = _mm_loadu_ps(batch.normalX), ny = _mm_loadu_ps(batch.normalY);
+
+    __m128 vn = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(v.bx, v.ax), nx), _mm_mul_ps(_mm_sub_ps(v.by, v.ay), ny));
+    __m128 oldImpulse = _mm_loadu_ps(batch.positionImpulse);
+    __m128 impulse = _mm_add_ps(oldImpulse, _mm_mul_ps(_mm_loadu_ps(batch.mass), _mm_sub_ps(_mm_loadu_ps(batch.positionBias), vn)));
+    impulse = _mm_max_ps(impulse, _mm_setzero_ps());
+    __m128 delta = _mm_sub_ps(impulse, oldImpulse);
+    _mm_storeu_ps(batch.positionImpulse, impulse);
+    v.ax = _mm_sub_ps(v.ax, _mm_mul_ps(_mm_mul_ps(nx, delta), v.ima));
+    v.ay = _mm_sub_ps(v.ay, _mm_mul_ps(_mm_mul_ps(ny, delta), v.ima));
+    v.bx = _mm_add_ps(v.bx, _mm_mul_ps(_mm_mul_ps(nx, delta), v.imb));
+    v.by = _mm_add_ps(v.by, _mm_mul_ps(_mm_mul_ps(ny, delta), v.imb));
+
+    scatterBodies(batch, v, pseudoVelocities);
+}
+
+#endif // SOLVER_X86
+
+} // namespace
+
+size_t ContactSolver::ContactCache::hash(const ContactKey& key) {
+    uint64_t h = key.a * 0x9E3779B97F4A7C15ull ^ key.b;
+    h ^= static_cast<uint64_t>(key.featureId) * 0xC2B2AE3D27D4EB4Full;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return static_cast<size_t>(h);
+}
+
+void ContactSolver::ContactCache::clear(size_t expected) {
+    size_t capacity = 16;
+    while (capacity < expected * 2) capacity *= 2;
+    CacheEntry empty = {};
+    empty.key.a = emptyKey;
+    entries.assign(capacity, empty);
+    count = 0;
+}
+
+const ContactSolver::CacheEntry* ContactSolver::ContactCache::find(const ContactKey& key) const {
+    if (entries.empty()) return nullptr;
+    const size_t mask = entries.size() - 1;
+    for (size_t i = hash(key) & mask;; i = (i + 1) & mask) {
+        const CacheEntry& entry = entries[i];
+        if (entry.key == key) return &entry;
+        if (entry.key.a == emptyKey) return nullptr;
+    }
+}
+
+void ContactSolver::ContactCache::insert(const ContactKey& key, float normalImpulse, float tangentImpulse) {
+    // clear() 保证至少一半是空位，探测一定会停下
+    const size_t mask = entries.size() - 1;
+    size_t i = hash(key) & mask;
+    while (entries[i].key.a != emptyKey && !(entries[i].key == key)) {
+        i = (i + 1) & mask;
+    }
+    if (entries[i].key.a == emptyKey) count++;
+    entries[i] = {key, normalImpulse, tangentImpulse};
+}
+
+void ContactSolver::setIterations(int count) {
+    iterations = std::max(count, 1);
+}
+
+void ContactSolver::reset() {
+    cache.clear(0);
+}
+
+uint32_t ContactSolver::addSolverBody(const BodyStore& bodies, uint32_t row) {
+    if (rowToSolver[row] == 0) {
+        rowToSolver[row] = static_cast<uint32_t>(solverRows.size());
+        solverRows.push_back(row);
+        solverVelocities.push_back(bodies.velocities[row]);
+        displacements.push_back(bodies.positions[row] - bodies.previousPositions[row]);
+        pseudoVelocities.push_back(glm::vec2(0.0f));
+        solverInverseMasses.push_back(bodies.inverseMasses[row]);
+    }
+    return rowToSolver[row];
+}
+
+void ContactSolver::colorConstraints() {
+    // 贪心着色：按约束顺序取两个物体都没用过的最小颜色，结果只取决于接触本身
+    const uint32_t constraintCount = static_cast<uint32_t>(constraints.size());
+    bodyColorMasks.assign(solverRows.size(), 0);
+    constraintColors.resize(constraintCount);
+    colorCounts.assign(maxParallelColors + 1, 0);
+    for (uint32_t i = 0; i < constraintCount; i++) {
+        const Constraint& c = constraints[i];
+        // 静态物体（逆质量为 0，包括地面）不会被写，不占颜色；大的静态地板或墙才不会占满所有颜色
+        bool dynamicA = solverInverseMasses[c.a] > 0.0f;
+        bool dynamicB = solverInverseMasses[c.b] > 0.0f;
+        uint64_t used = (dynamicA ? bodyColorMasks[c.a] : 0) | (dynamicB ? bodyColorMasks[c.b] : 0);
+        uint32_t color = maxParallelColors;
+        if (used != ~0ull) {
+            color = 0;
+            while (used & (1ull << color)) color++;
+            if (dynamicA) bodyColorMasks[c.a] |= 1ull << color;
+            if (dynamicB) bodyColorMasks[c.b] |= 1ull << color;
+        }
+        constraintColors[i] = color;
+        colorCounts[color]++;
+    }
+
+    // 每个颜色的约束按顺序装进批，每批占满所有通道；溢出的颜色一批只放一个
+    hasOverflowColor = colorCounts[maxParallelColors] > 0;
+    uint32_t usedColors = 0;
+    for (uint32_t color = 0; color < maxParallelColors; color++) {
+        if (colorCounts[color] > 0) usedColors = color + 1;
+    }
+    colorBatchStarts.assign(1, 0);
+    std::vector<uint32_t>& batchCursor = colorCounts;   // 复用：改存每个颜色的下一个空位
+    uint32_t batchCount = 0;
+    for (uint32_t color = 0; color <= maxParallelColors; color++) {
+        if (color >= usedColors && !(color == maxParallelColors && hasOverflowColor)) continue;
+        uint32_t count = colorCounts[color];
+        batchCursor[color] = batchCount * lanes;
+        batchCount += color == maxParallelColors ? count : (count + lanes - 1) / lanes;
+        colorBatchStarts.push_back(batchCount);
+    }
+
+    Batch empty = {};
+    batches.assign(batchCount, empty);
+    batchConstraints.assign(batchCount * lanes, invalidConstraint);
+    for (uint32_t i = 0; i < constraintCount; i++) {
+        const Constraint& c = constraints[i];
+        uint32_t color = constraintColors[i];
+        uint32_t slot = batchCursor[color];
+        batchCursor[color] += color == maxParallelColors ? lanes : 1;
+
+        Batch& batch = batches[slot / lanes];
+        uint32_t lane = slot % lanes;
+        batch.a[lane] = c.a;
+        batch.b[lane] = c.b;
+        batch.normalX[lane] = c.normal.x;
+        batch.normalY[lane] = c.normal.y;
+        batch.mass[lane] = c.mass;
+        batch.bias[lane] = c.bias;
+        batch.positionBias[lane] = c.positionBias;
+        batch.friction[lane] = c.friction;
+        batch.normalImpulse[lane] = c.normalImpulse;
+        batch.tangentImpulse[lane] = c.tangentImpulse;
+        batchConstraints[slot] = i;
+    }
+}
+
+template<typename Kernel>
+void ContactSolver::forEachBatch(Kernel&& kernel) {
+    const uint32_t colorCount = static_cast<uint32_t>(colorBatchStarts.size()) - 1;
+    for (uint32_t color = 0; color < colorCount; color++) {
+        uint32_t begin = colorBatchStarts[color];
+        uint32_t count = colorBatchStarts[color + 1] - begin;
+        // 同一颜色的批没有共享的物体，可以任意并行；溢出颜色必须按顺序执行
+        bool serial = !jobs || (hasOverflowColor && color == colorCount - 1);
+        if (serial) {
+            for (uint32_t i = 0; i < count; i++) kernel(batches[begin + i]);
+            continue;
+        }
+        jobs->parallelFor(count, batchGrainSize, [&](uint32_t chunkBegin, uint32_t chunkEnd) {
+            for (uint32_t i = chunkBegin; i < chunkEnd; i++) kernel(batches[begin + i]);
+        });
+    }
+}
+
+void ContactSolver::solve(BodyStore& bodies, const std::vector<uint64_t>& bodyIds, const std::vector<ContactManifold>& manifolds,
+                          float deltaTime, float groundLevel) {
+    const float inverseDeltaTime = deltaTime > 0.0f ? 1.0f / deltaTime : 0.0f;
+
+    // 求解用的物体：下标 0 是静态的地面，其余是接触涉及的物体
+    solverRows.assign(1, 0);
+    solverVelocities.assign(1, glm::vec2(0.0f));
+    displacements.assign(1, glm::vec2(0.0f));
+    pseudoVelocities.assign(1, glm::vec2(0.0f));
+    solverInverseMasses.assign(1, 0.0f);
+    rowToSolver.resize(bodies.size(), 0);
+
+    // 深度是在积分后的位置上测的，加回积分（含地面钳制）走过的位移就是这一步开始时的深度。
+    // 求解后的物体从开始的位置按求解的速度重走这一步，所以速度目标除了反弹，只允许靠近到深度刚好
+    // 等于容差：静止的接触速度正好为零，也不会停在一点缝隙上时有时无。
+    // 超出容差的穿透交给伪速度；这里先按开始的深度算，速度迭代之后再扣掉速度走过的距离
+    auto addConstraint = [&](uint32_t a, uint32_t b, glm::vec2 normal, float depth, float restitution, float friction,
+                             const ContactKey& key) {
+        Constraint c;
+        c.a = a;
+        c.b = b;
+        c.normal = normal;
+        c.mass = 1.0f / (solverInverseMasses[a] + solverInverseMasses[b]);
+        c.friction = friction;
+        c.key = key;
+
+        float normalVelocity = glm::dot(solverVelocities[b] - solverVelocities[a], normal);
+        float startDepth = depth + glm::dot(displacements[b] - displacements[a], normal);
+        float approach = std::min((startDepth - penetrationSlop) * inverseDeltaTime, 0.0f);
+        c.bias = normalVelocity < -restitutionThreshold ? -restitution * normalVelocity : approach;
+        c.positionBias = baumgarteFactor * inverseDeltaTime * (startDepth - penetrationSlop);
+        c.normalImpulse = 0.0f;
+        c.tangentImpulse = 0.0f;
+        if (warmStarting) {
+            if (const CacheEntry* cached = cache.find(key)) {
+                c.normalImpulse = cached->normalImpulse;
+                c.tangentImpulse = cached->tangentImpulse;
+            }
+        }
+        constraints.push_back(c);
+    };
+
+    // 建立约束
+    constraints.clear();
+    for (const ContactManifold& manifold : manifolds) {
+        uint32_t a = addSolverBody(bodies, manifold.a);
+        uint32_t b = addSolverBody(bodies, manifold.b);
+        if (solverInverseMasses[a] + solverInverseMasses[b] <= 0.0f) continue;
+
+        float restitution = (bodies.elasticities[manifold.a] + bodies.elasticities[manifold.b]) * 0.5f;
+        float friction = (bodies.frictions[manifold.a] + bodies.frictions[manifold.b]) * 0.5f;
+        // 键里小的 id 在前，行的顺序变了（睡眠、删除时换行）还能找到上一步的冲量；
+        // 特征编号由细检测按同样的顺序算出，不用再换
+        uint64_t idA = bodyIds[manifold.a], idB = bodyIds[manifold.b];
+        uint64_t lowId = std::min(idA, idB), highId = std::max(idA, idB);
+        for (uint32_t p = 0; p < manifold.pointCount; p++) {
+            const ContactPoint& point = manifold.points[p];
+            addConstraint(a, b, manifold.normal, point.depth, restitution, friction, {lowId, highId, point.featureId});
+        }
+    }
+
+    // 接触中的物体落在地面上时加一个地面约束，堆叠的重量才能传到地面
+    const uint32_t solverBodyCount = static_cast<uint32_t>(solverRows.size());
+    for (uint32_t body = 1; body < solverBodyCount; body++) {
+        uint32_t row = solverRows[body];
+        if (bodies.positions[row].y > groundLevel + penetrationSlop || solverInverseMasses[body] <= 0.0f) continue;
+        // 积分器把物体钳在地面上，地面不留容差：深度加上容差，目标正好是地面
+        addConstraint(0, body, glm::vec2(0.0f, 1.0f), groundLevel - bodies.positions[row].y + penetrationSlop, bodies.elasticities[row],
+                      bodies.frictions[row], {bodyIds[row], groundKey, 0});
+    }
+
+    colorConstraints();
+
+    // 热启动：先施加上一步累积的冲量
+    glm::vec2* velocities = solverVelocities.data();
+    glm::vec2* pseudo = pseudoVelocities.data();
+    const float* inverseMasses = solverInverseMasses.data();
+    for (const Constraint& c : constraints) {
+        glm::vec2 tangent(-c.normal.y, c.normal.x);
+        glm::vec2 impulse = c.normal * c.normalImpulse + tangent * c.tangentImpulse;
+        if (c.a != 0) velocities[c.a] -= impulse * inverseMasses[c.a];
+        velocities[c.b] += impulse * inverseMasses[c.b];
+    }
+
+    // 速度迭代，然后是只作用在伪速度上的穿透修正（不热启动）
+#if SOLVER_X86
+    if (simdLevel >= SimdLevel::SSE4) {
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            forEachBatch([&](Batch& batch) { solveVelocitySSE4(batch, velocities, inverseMasses); });
+        }
+        forEachBatch([&](Batch& batch) { updatePositionBias(batch, velocities); });
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            forEachBatch([&](Batch& batch) { solvePositionSSE4(batch, pseudo, inverseMasses); });
+        }
+    } else
+#endif
+    {
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            forEachBatch([&](Batch& batch) { solveVelocityScalar(batch, velocities, inverseMasses); });
+        }
+        forEachBatch([&](Batch& batch) { updatePositionBias(batch, velocities); });
+        for (int iteration = 0; iteration < iterations; iteration++) {
+            forEachBatch([&](Batch& batch) { solvePositionScalar(batch, pseudo, inverseMasses); });
+        }
+    }
+
+    // 保存累积冲量给下一步；这一步没有出现的接触自然被丢掉
+    nextCache.clear(constraints.size());
+    for (size_t slot = 0; slot < batchConstraints.size(); slot++) {
+        uint32_t index = batchConstraints[slot];
+        if (index == invalidConstraint) continue;
+        const Batch& batch = batches[slot / lanes];
+        nextCache.insert(constraints[index].key, batch.normalImpulse[slot % lanes], batch.tangentImpulse[slot % lanes]);
+    }
+    std::swap(cache, nextCache);
+
+    // 积分用旧速度移动过物体，这里从这一步开始的位置按求解后的速度和伪速度重走一遍，
+    // 深度和位移对得上，每步按比例消掉超出容差的穿透
+    for (uint32_t body = 1; body < solverBodyCount; body++) {
+        uint32_t row = solverRows[body];
+        bodies.velocities[row] = velocities[body];
+        bodies.positions[row] = bodies.previousPositions[row] + (velocities[body] + pseudo[body]) * deltaTime;
+        bodies.updateGeometry(row);
+        rowToSolver[row] = 0;
+    }
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "BodyStore.h"
+#include "Integrator.h"
+#include "Narrowphase.h"
+
+class JobSystem;
+
+// Sequential-impulse solver for contact constraints. Every step it runs a fixed number of
+// velocity iterations over all contact points, clamping the accumulated normal impulse to push
+// only and the friction impulse to the friction cone. Accumulated impulses are kept in a hash map
+// keyed by body pair and feature id, and the next step starts from them (warm starting), so
+// resting stacks begin near the solution instead of from zero.
+//
+// Overlap is removed by split impulses: a separate pseudo-velocity pass pushes a fraction of the
+// depth beyond a small slop apart each step and only moves the bodies, so position correction
+// adds no bounce. Depths are measured after integration; adding back how far the integrator moved
+// the two bodies gives the depth at the start of the step, and the touched bodies are moved again
+// from there with the solved velocity. So velocities are solved before the position update, the
+// pass only corrects what is left after it, and resting contacts end with zero velocity.
+//
+// Bodies have no rotation, so all terms are linear. Bodies in contact that rest on the ground
+// plane also get a ground constraint, so the bottom of a stack carries the weight above it.
+//
+// Constraints are greedily graph-coloured so that no two of the same colour share a dynamic body,
+// then packed four to a batch, one per SIMD lane. Colours are solved one after another and the
+// batches of a colour in parallel, without locks. The colouring only depends on the contacts, and
+// every SIMD level does the same operations in the same order, so the result depends on neither
+// the thread count nor the instruction set.
+class ContactSolver {
+public:
+    // Closing speeds below this do not bounce; the integrator uses it for the ground plane too.
+    // The closing speed includes the step's gravity, so it has to stay above what a body resting
+    // on another gains from gravity between bounces, or the bounce never dies out.
+    static constexpr float restitutionThreshold = 1.0f;
+
+    void setIterations(int count);
+    int getIterations() const { return iterations; }
+    void setWarmStarting(bool enabled) { warmStarting = enabled; }
+    bool getWarmStarting() const { return warmStarting; }
+
+    // Worker pool for the batches of a colour; null solves everything on the calling thread
+    void setJobSystem(JobSystem* system) { jobs = system; }
+    // Scalar or SSE4 lanes; AVX2 uses the SSE4 kernel
+    void setSimdLevel(SimdLevel level) { simdLevel = level; }
+
+    // Solves the manifolds, then moves each touched body from its position at the start of the
+    // step (BodyStore::previousPositions) by the solved velocity times deltaTime, replacing the
+    // integrator's move. bodyIds gives every row an id that stays the same when rows are
+    // reordered and is never reused (the engine passes handle slot and generation); cached
+    // impulses are keyed by the lower id, the higher id and the feature id, which must also be
+    // given in that order.
+    void solve(BodyStore& bodies, const std::vector<uint64_t>& bodyIds, const std::vector<ContactManifold>& manifolds,
+               float deltaTime, float groundLevel);
+
+    // Drops the cached impulses
+    void reset();
+
+    // Contact points solved in the last step
+    size_t getContactCount() const { return cache.count; }
+    // Colours of the last step, including the serial overflow colour if it was needed
+    size_t getColorCount() const { return colorBatchStarts.empty() ? 0 : colorBatchStarts.size() - 1; }
+
+    // Lanes per constraint batch
+    static constexpr uint32_t laneCount = 4;
+
+    // Up to laneCount constraints that share no dynamic body. Body indices refer to the solver
+    // bodies; index 0 is the static ground. Bodies with inverse mass 0 (the ground and any other
+    // static body) are never written, so they take no colour. Unused lanes point at the ground
+    // with zero mass, so they apply no impulse.
+    struct ConstraintBatch {
+        uint32_t a[laneCount];
+        uint32_t b[laneCount];
+        float normalX[laneCount];   // from a to b
+        float normalY[laneCount];
+        float mass[laneCount];      // 1 / (inverse mass a + inverse mass b)
+        float bias[laneCount];      // target separating velocity
+        float positionBias[laneCount];   // target pseudo velocity, set after the velocity iterations
+        float friction[laneCount];
+        float normalImpulse[laneCount];   // accumulated
+        float tangentImpulse[laneCount];
+        float positionImpulse[laneCount];
+    };
+
+private:
+    struct ContactKey {
+        uint64_t a;
+        uint64_t b;
+        uint32_t featureId;
+
+        bool operator==(const ContactKey& other) const { return a == other.a && b == other.b && featureId == other.featureId; }
+    };
+    // Open-addressing hash map of accumulated impulses: linear probing over a power-of-two
+    // table at most half full, rebuilt every step, so lookups touch one or two cache lines
+    struct CacheEntry {
+        ContactKey key;   // key.a == emptyKey while the entry is free
+        float normalImpulse;
+        float tangentImpulse;
+    };
+    struct ContactCache {
+        static constexpr uint64_t emptyKey = ~0ull;
+
+        std::vector<CacheEntry> entries;
+        size_t count = 0;
+
+        // Empties the table and sizes it for up to `expected` entries
+        void clear(size_t expected);
+        const CacheEntry* find(const ContactKey& key) const;
+        void insert(const ContactKey& key, float normalImpulse, float tangentImpulse);
+        static size_t hash(const ContactKey& key);
+    };
+    struct Constraint {
+        uint32_t a;   // solver bodies
+        uint32_t b;
+        glm::vec2 normal;
+        float mass;
+        float bias;
+        float positionBias;
+        float friction;
+        float normalImpulse;
+        float tangentImpulse;
+        ContactKey key;
+    };
+
+    int iterations = 12;
+    bool warmStarting = true;
+    JobSystem* jobs = nullptr;
+    SimdLevel simdLevel = SimdLevel::Scalar;
+
+    ContactCache cache;
+    ContactCache nextCache;
+
+    // Solver bodies: every body touched by a contact, behind the static ground at index 0
+    std::vector<uint32_t> solverRows;          // body row of each solver body
+    std::vector<uint32_t> rowToSolver;         // per body row, 0 while untouched
+    std::vector<glm::vec2> solverVelocities;
+    std::vector<glm::vec2> displacements;      // move of the integrator this step
+    std::vector<glm::vec2> pseudoVelocities;
+    std::vector<float> solverInverseMasses;
+
+    std::vector<Constraint> constraints;
+    std::vector<uint32_t> constraintColors;
+    std::vector<uint64_t> bodyColorMasks;      // colours already used by each solver body
+    std::vector<uint32_t> colorCounts;
+    std::vector<ConstraintBatch> batches;      // grouped by colour
+    std::vector<uint32_t> batchConstraints;    // constraint of each lane, or invalidConstraint
+    std::vector<uint32_t> colorBatchStarts;    // colour c owns batches [starts[c], starts[c + 1])
+    bool hasOverflowColor = false;             // last colour is solved serially, one constraint per batch
+
+    uint32_t addSolverBody(const BodyStore& bodies, uint32_t row);
+    void colorConstraints();
+    // Runs kernel(batch) over all batches, colour by colour
+    template<typename Kernel>
+    void forEachBatch(Kernel&& kernel);
+};
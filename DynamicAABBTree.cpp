@@ -0,0 +1,297 @@
+#include "DynamicAABBTree.h"
+#include <cassert>
+
+using namespace aabbtree;
+
+DynamicAABBTree::DynamicAABBTree() : root(nullNode), freeList(nullNode), proxyCount(0), fatMargin(0.02f) {}
+
+void DynamicAABBTree::clear() {
+    nodes.clear();
+    root = nullNode;
+    freeList = nullNode;
+    proxyCount = 0;
+}
+
+int DynamicAABBTree::allocateNode() {
+    if (freeList == nullNode) {
+        nodes.push_back({});
+        freeList = static_cast<int>(nodes.size()) - 1;
+        nodes[freeList].parent = nullNode;
+    }
+
+    int nodeId = freeList;
+    freeList = nodes[nodeId].parent;
+    Node& node = nodes[nodeId];
+    node.parent = nullNode;
+    node.child1 = nullNode;
+    node.child2 = nullNode;
+    node.height = 0;
+    node.userData = 0;
+    return nodeId;
+}
+
+void DynamicAABBTree::freeNode(int nodeId) {
+    nodes[nodeId].parent = freeList;
+    nodes[nodeId].height = -1;
+    freeList = nodeId;
+}
+
+AABB DynamicAABBTree::fatten(const AABB& box, const glm::vec2& displacement) const {
+    // 四周加边距，再沿运动方向预留位移
+    AABB fat = {box.min - glm::vec2(fatMargin), box.max + glm::vec2(fatMargin)};
+    glm::vec2 predicted = displacement * 2.0f;
+    fat.min += glm::min(predicted, glm::vec2(0.0f));
+    fat.max += glm::max(predicted, glm::vec2(0.0f));
+    return fat;
+}
+
+int DynamicAABBTree::createProxy(const AABB& box, uint32_t userData) {
+    int proxyId = allocateNode();
+    nodes[proxyId].box = fatten(box, glm::vec2(0.0f));
+    nodes[proxyId].userData = userData;
+    insertLeaf(proxyId);
+    proxyCount++;
+    return proxyId;
+}
+
+void DynamicAABBTree::destroyProxy(int proxyId) {
+    assert(nodes[proxyId].isLeaf());
+    removeLeaf(proxyId);
+    freeNode(proxyId);
+    proxyCount--;
+}
+
+bool DynamicAABBTree::moveProxy(int proxyId, const AABB& box) {
+    assert(nodes[proxyId].isLeaf());
+
+    AABB oldFat = nodes[proxyId].box;
+    if (contains(oldFat, box)) {
+        return false;
+    }
+
+    glm::vec2 displacement = (box.min + box.max) * 0.5f - (oldFat.min + oldFat.max) * 0.5f;
+    AABB newFat = fatten(box, displacement);
+
+    if (newFat.overlaps(oldFat)) {
+        // 小幅移动：原地更新叶子，只重算祖先的包围盒
+        nodes[proxyId].box = newFat;
+        refitAncestors(nodes[proxyId].parent);
+    } else {
+        // 移动太远：重新插入以保持树的质量
+        removeLeaf(proxyId);
+        nodes[proxyId].box = newFat;
+        insertLeaf(proxyId);
+    }
+    return true;
+}
+
+void DynamicAABBTree::refitAncestors(int nodeId) {
+    while (nodeId != nullNode) {
+        Node& node = nodes[nodeId];
+        AABB refitted = combine(nodes[node.child1].box, nodes[node.child2].box);
+        if (refitted.min == node.box.min && refitted.max == node.box.max) {
+            break;
+        }
+        node.box = refitted;
+        nodeId = node.parent;
+    }
+}
+
+void DynamicAABBTree::insertLeaf(int leaf) {
+    if (root == nullNode) {
+        root = leaf;
+        nodes[root].parent = nullNode;
+        return;
+    }
+
+    // 按周长代价下降，找到最佳兄弟节点
+    AABB leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].isLeaf()) {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = perimeter(nodes[index].box);
+        float combinedArea = perimeter(combine(nodes[index].box, leafBox));
+
+        // 在这里新建父节点的代价
+        float cost = 2.0f * combinedArea;
+        // 继续下降时祖先要增加的代价
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int child) {
+            AABB box = combine(leafBox, nodes[child].box);
+            if (nodes[child].isLeaf()) {
+                return perimeter(box) + inheritanceCost;
+            }
+            return perimeter(box) - perimeter(nodes[child].box) + inheritanceCost;
+        };
+        float cost1 = descendCost(child1);
+        float cost2 = descendCost(child2);
+
+        if (cost < cost1 && cost < cost2) break;
+        index = cost1 < cost2 ? child1 : child2;
+    }
+
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = combine(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != nullNode) {
+        if (nodes[oldParent].child1 == sibling) {
+            nodes[oldParent].child1 = newParent;
+        } else {
+            nodes[oldParent].child2 = newParent;
+        }
+    } else {
+        root = newParent;
+    }
+
+    // 向上修正包围盒和高度，并做旋转平衡
+    index = nodes[leaf].parent;
+    while (index != nullNode) {
+        index = balance(index);
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[index].box = combine(nodes[child1].box, nodes[child2].box);
+        index = nodes[index].parent;
+    }
+}
+
+void DynamicAABBTree::removeLeaf(int leaf) {
+    if (leaf == root) {
+        root = nullNode;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent != nullNode) {
+        // 删除父节点，兄弟节点接到祖父节点上
+        if (nodes[grandParent].child1 == parent) {
+            nodes[grandParent].child1 = sibling;
+        } else {
+            nodes[grandParent].child2 = sibling;
+        }
+        nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        int index = grandParent;
+        while (index != nullNode) {
+            index = balance(index);
+            int child1 = nodes[index].child1;
+            int child2 = nodes[index].child2;
+            nodes[index].box = combine(nodes[child1].box, nodes[child2].box);
+            nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+            index = nodes[index].parent;
+        }
+    } else {
+        root = sibling;
+        nodes[sibling].parent = nullNode;
+        freeNode(parent);
+    }
+}
+
+// 以 A 为根，若左右子树高度差超过 1 则做一次旋转，返回新的子树根
+int DynamicAABBTree::balance(int iA) {
+    Node& A = nodes[iA];
+    if (A.isLeaf() || A.height < 2) {
+        return iA;
+    }
+
+    int iB = A.child1;
+    int iC = A.child2;
+    int heightDiff = nodes[iC].height - nodes[iB].height;
+
+    // C 较高：把 C 提上来
+    if (heightDiff > 1) {
+        int iF = nodes[iC].child1;
+        int iG = nodes[iC].child2;
+        Node& C = nodes[iC];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+
+        if (C.parent != nullNode) {
+            if (nodes[C.parent].child1 == iA) {
+                nodes[C.parent].child1 = iC;
+            } else {
+                nodes[C.parent].child2 = iC;
+            }
+        } else {
+            root = iC;
+        }
+
+        if (nodes[iF].height > nodes[iG].height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            nodes[iG].parent = iA;
+            A.box = combine(nodes[iB].box, nodes[iG].box);
+            C.box = combine(A.box, nodes[iF].box);
+            A.height = 1 + std::max(nodes[iB].height, nodes[iG].height);
+            C.height = 1 + std::max(A.height, nodes[iF].height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            nodes[iF].parent = iA;
+            A.box = combine(nodes[iB].box, nodes[iF].box);
+            C.box = combine(A.box, nodes[iG].box);
+            A.height = 1 + std::max(nodes[iB].height, nodes[iF].height);
+            C.height = 1 + std::max(A.height, nodes[iG].height);
+        }
+        return iC;
+    }
+
+    // B 较高：把 B 提上来
+    if (heightDiff < -1) {
+        int iD = nodes[iB].child1;
+        int iE = nodes[iB].child2;
+        Node& B = nodes[iB];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+
+        if (B.parent != nullNode) {
+            if (nodes[B.parent].child1 == iA) {
+                nodes[B.parent].child1 = iB;
+            } else {
+                nodes[B.parent].child2 = iB;
+            }
+        } else {
+            root = iB;
+        }
+
+        if (nodes[iD].height > nodes[iE].height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            nodes[iE].parent = iA;
+            A.box = combine(nodes[iC].box, nodes[iE].box);
+            B.box = combine(A.box, nodes[iD].box);
+            A.height = 1 + std::max(nodes[iC].height, nodes[iE].height);
+            B.height = 1 + std::max(A.height, nodes[iD].height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            nodes[iD].parent = iA;
+            A.box = combine(nodes[iC].box, nodes[iD].box);
+            B.box = combine(A.box, nodes[iE].box);
+            A.height = 1 + std::max(nodes[iC].height, nodes[iD].height);
+            B.height = 1 + std::max(A.height, nodes[iE].height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
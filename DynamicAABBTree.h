@@ -0,0 +1,171 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "AABB.h"
+
+// Dynamic bounding volume hierarchy over fattened AABBs (after Box2D's b2DynamicTree).
+// Leaves store enlarged boxes, so a proxy only has to be touched when its tight box leaves the fat one.
+// Insertion picks the sibling by surface-area cost and rotations keep the tree height balanced.
+class DynamicAABBTree {
+public:
+    static constexpr int nullNode = -1;
+
+    struct RayCastInput {
+        glm::vec2 p1;
+        glm::vec2 p2;
+        float maxFraction;
+    };
+
+    DynamicAABBTree();
+
+    // Proxy management. Returned ids stay valid until destroyProxy.
+    int createProxy(const AABB& box, uint32_t userData);
+    void destroyProxy(int proxyId);
+    // Returns true when the fat box had to change. Small moves refit the ancestors in place,
+    // large ones remove and reinsert the leaf.
+    bool moveProxy(int proxyId, const AABB& box);
+
+    const AABB& getFatAABB(int proxyId) const { return nodes[proxyId].box; }
+    uint32_t getUserData(int proxyId) const { return nodes[proxyId].userData; }
+    int getHeight() const { return root == nullNode ? 0 : nodes[root].height; }
+    int getProxyCount() const { return proxyCount; }
+
+    void setFatMargin(float margin) { fatMargin = margin; }
+    float getFatMargin() const { return fatMargin; }
+    void clear();
+
+    // Calls callback(proxyId) for every leaf whose fat box overlaps the region; return false to stop
+    template<typename Callback>
+    void query(const AABB& region, Callback&& callback) const;
+
+    // Calls callback(input, proxyId) for every leaf whose fat box the segment p1 -> p1 + maxFraction * (p2 - p1)
+    // crosses. The callback returns the new max fraction: 0 stops the cast, a smaller value clips it,
+    // a negative value ignores the proxy.
+    template<typename Callback>
+    void rayCast(const RayCastInput& input, Callback&& callback) const;
+
+private:
+    struct Node {
+        AABB box;
+        int parent;   // doubles as the free list link
+        int child1;
+        int child2;
+        int height;   // leaf = 0, free node = -1
+        uint32_t userData;
+
+        bool isLeaf() const { return child1 == nullNode; }
+    };
+
+    std::vector<Node> nodes;
+    int root;
+    int freeList;
+    int proxyCount;
+    float fatMargin;
+    mutable std::vector<int> stack;
+
+    int allocateNode();
+    void freeNode(int nodeId);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    void refitAncestors(int nodeId);
+    int balance(int nodeId);
+    AABB fatten(const AABB& box, const glm::vec2& displacement) const;
+};
+
+namespace aabbtree {
+
+inline AABB combine(const AABB& lhs, const AABB& rhs) {
+    return {glm::min(lhs.min, rhs.min), glm::max(lhs.max, rhs.max)};
+}
+
+inline bool contains(const AABB& outer, const AABB& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+           inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+inline float perimeter(const AABB& box) {
+    glm::vec2 extent = box.max - box.min;
+    return 2.0f * (extent.x + extent.y);
+}
+
+} // namespace aabbtree
+
+template<typename Callback>
+void DynamicAABBTree::query(const AABB& region, Callback&& callback) const {
+    if (root == nullNode) return;
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[nodeId];
+        if (!node.box.overlaps(region)) continue;
+
+        if (node.isLeaf()) {
+            if (!callback(nodeId)) return;
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
+
+template<typename Callback>
+void DynamicAABBTree::rayCast(const RayCastInput& input, Callback&& callback) const {
+    if (root == nullNode) return;
+
+    glm::vec2 p1 = input.p1;
+    glm::vec2 d = input.p2 - input.p1;
+    float maxFraction = input.maxFraction;
+
+    // Bounding box of the remaining segment, used for a quick reject before the slab test
+    glm::vec2 end = p1 + maxFraction * d;
+    AABB segmentBox = {glm::min(p1, end), glm::max(p1, end)};
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        int nodeId = stack.back();
+        stack.pop_back();
+
+        const Node& node = nodes[nodeId];
+        if (!node.box.overlaps(segmentBox)) continue;
+
+        // Slab test against the node box
+        float tMin = 0.0f;
+        float tMax = maxFraction;
+        bool hit = true;
+        for (int axis = 0; axis < 2 && hit; axis++) {
+            if (std::abs(d[axis]) < 1e-12f) {
+                hit = p1[axis] >= node.box.min[axis] && p1[axis] <= node.box.max[axis];
+            } else {
+                float invD = 1.0f / d[axis];
+                float t1 = (node.box.min[axis] - p1[axis]) * invD;
+                float t2 = (node.box.max[axis] - p1[axis]) * invD;
+                tMin = std::max(tMin, std::min(t1, t2));
+                tMax = std::min(tMax, std::max(t1, t2));
+                hit = tMin <= tMax;
+            }
+        }
+        if (!hit) continue;
+
+        if (node.isLeaf()) {
+            RayCastInput subInput = {input.p1, input.p2, maxFraction};
+            float value = callback(subInput, nodeId);
+            if (value == 0.0f) return;
+            if (value > 0.0f && value < maxFraction) {
+                maxFraction = value;
+                end = p1 + maxFraction * d;
+                segmentBox = {glm::min(p1, end), glm::max(p1, end)};
+            }
+        } else {
+            stack.push_back(node.child1);
+            stack.push_back(node.child2);
+        }
+    }
+}
@@ -0,0 +1,346 @@
+#include "Gjk.h"
+#include <algorithm>
+#include <cfloat>
+
+namespace {
+
+constexpr uint32_t maxGjkIterations = 20;
+constexpr uint32_t maxEpaIterations = 32;
+constexpr uint32_t maxPolytopeVertices = maxEpaIterations + 3;
+// 支撑点不再让最近的边往外推时停下
+constexpr float epaTolerance = 1.0e-6f;
+// 单纯形方向或面积小于这个值视为退化
+constexpr float degenerateEpsilon = 1.0e-12f;
+
+float cross(const glm::vec2& a, const glm::vec2& b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+// 单纯形的一个顶点：w = wB - wA 是闵可夫斯基差 B - A 上的点，a 是重心坐标
+struct SimplexVertex {
+    glm::vec2 wA;
+    glm::vec2 wB;
+    glm::vec2 w;
+    float a;
+    uint32_t indexA;
+    uint32_t indexB;
+};
+
+struct Simplex {
+    SimplexVertex v[3];
+    uint32_t count;
+
+    void read(const SimplexCache& cache, const ConvexProxy& proxyA, const ConvexProxy& proxyB) {
+        count = cache.count;
+        for (uint32_t i = 0; i < count; i++) {
+            setVertex(v[i], cache.indexA[i], cache.indexB[i], proxyA, proxyB);
+        }
+        // 缓存的单纯形退化了就从头开始
+        if (count == 2 && glm::dot(v[1].w - v[0].w, v[1].w - v[0].w) < degenerateEpsilon) count = 0;
+        if (count == 3 && std::abs(cross(v[1].w - v[0].w, v[2].w - v[0].w)) < degenerateEpsilon) count = 0;
+        if (count == 0) {
+            setVertex(v[0], 0, 0, proxyA, proxyB);
+            count = 1;
+        }
+        for (uint32_t i = 0; i < count; i++) v[i].a = 1.0f / static_cast<float>(count);
+    }
+
+    void write(SimplexCache& cache) const {
+        cache.count = count;
+        for (uint32_t i = 0; i < count; i++) {
+            cache.indexA[i] = v[i].indexA;
+            cache.indexB[i] = v[i].indexB;
+        }
+    }
+
+    static void setVertex(SimplexVertex& vertex, uint32_t indexA, uint32_t indexB, const ConvexProxy& proxyA,
+                          const ConvexProxy& proxyB) {
+        vertex.indexA = indexA;
+        vertex.indexB = indexB;
+        vertex.wA = proxyA.point(indexA);
+        vertex.wB = proxyB.point(indexB);
+        vertex.w = vertex.wB - vertex.wA;
+        vertex.a = 1.0f;
+    }
+
+    // 从单纯形指向原点的方向
+    glm::vec2 searchDirection() const {
+        if (count == 1) return -v[0].w;
+        glm::vec2 edge = v[1].w - v[0].w;
+        return cross(edge, -v[0].w) > 0.0f ? glm::vec2(-edge.y, edge.x) : glm::vec2(edge.y, -edge.x);
+    }
+
+    void witnessPoints(glm::vec2& pointA, glm::vec2& pointB) const {
+        pointA = glm::vec2(0.0f);
+        pointB = glm::vec2(0.0f);
+        for (uint32_t i = 0; i < count; i++) {
+            pointA += v[i].a * v[i].wA;
+            pointB += v[i].a * v[i].wB;
+        }
+        if (count == 3) pointB = pointA;
+    }
+
+    // 线段上离原点最近的点，用重心坐标表示
+    void solve2() {
+        glm::vec2 edge = v[1].w - v[0].w;
+        float d2 = -glm::dot(v[0].w, edge);
+        if (d2 <= 0.0f) {
+            v[0].a = 1.0f;
+            count = 1;
+            return;
+        }
+        float d1 = glm::dot(v[1].w, edge);
+        if (d1 <= 0.0f) {
+            v[1].a = 1.0f;
+            v[0] = v[1];
+            count = 1;
+            return;
+        }
+        float inverse = 1.0f / (d1 + d2);
+        v[0].a = d1 * inverse;
+        v[1].a = d2 * inverse;
+        count = 2;
+    }
+
+    // 三角形的 Voronoi 区域：顶点、边或内部
+    void solve3() {
+        const glm::vec2 w1 = v[0].w, w2 = v[1].w, w3 = v[2].w;
+
+        glm::vec2 e12 = w2 - w1;
+        float d12_1 = glm::dot(w2, e12);
+        float d12_2 = -glm::dot(w1, e12);
+        glm::vec2 e13 = w3 - w1;
+        float d13_1 = glm::dot(w3, e13);
+        float d13_2 = -glm::dot(w1, e13);
+        glm::vec2 e23 = w3 - w2;
+        float d23_1 = glm::dot(w3, e23);
+        float d23_2 = -glm::dot(w2, e23);
+
+        float n123 = cross(e12, e13);
+        float d123_1 = n123 * cross(w2, w3);
+        float d123_2 = n123 * cross(w3, w1);
+        float d123_3 = n123 * cross(w1, w2);
+
+        if (d12_2 <= 0.0f && d13_2 <= 0.0f) {
+            v[0].a = 1.0f;
+            count = 1;
+            return;
+        }
+        if (d12_1 > 0.0f && d12_2 > 0.0f && d123_3 <= 0.0f) {
+            float inverse = 1.0f / (d12_1 + d12_2);
+            v[0].a = d12_1 * inverse;
+            v[1].a = d12_2 * inverse;
+            count = 2;
+            return;
+        }
+        if (d13_1 > 0.0f && d13_2 > 0.0f && d123_2 <= 0.0f) {
+            float inverse = 1.0f / (d13_1 + d13_2);
+            v[0].a = d13_1 * inverse;
+            v[2].a = d13_2 * inverse;
+            v[1] = v[2];
+            count = 2;
+            return;
+        }
+        if (d12_1 <= 0.0f && d23_2 <= 0.0f) {
+            v[1].a = 1.0f;
+            v[0] = v[1];
+            count = 1;
+            return;
+        }
+        if (d13_1 <= 0.0f && d23_1 <= 0.0f) {
+            v[2].a = 1.0f;
+            v[0] = v[2];
+            count = 1;
+            return;
+        }
+        if (d23_1 > 0.0f && d23_2 > 0.0f && d123_1 <= 0.0f) {
+            float inverse = 1.0f / (d23_1 + d23_2);
+            v[1].a = d23_1 * inverse;
+            v[2].a = d23_2 * inverse;
+            v[0] = v[2];
+            count = 2;
+            return;
+        }
+        float inverse = 1.0f / (d123_1 + d123_2 + d123_3);
+        v[0].a = d123_1 * inverse;
+        v[1].a = d123_2 * inverse;
+        v[2].a = d123_3 * inverse;
+        count = 3;
+    }
+};
+
+struct PolytopeVertex {
+    glm::vec2 w;
+    uint32_t indexA;
+    uint32_t indexB;
+};
+
+PolytopeVertex supportVertex(const ConvexProxy& proxyA, const ConvexProxy& proxyB, const glm::vec2& direction) {
+    uint32_t indexA = proxyA.support(-direction);
+    uint32_t indexB = proxyB.support(direction);
+    return {proxyB.point(indexB) - proxyA.point(indexA), indexA, indexB};
+}
+
+} // namespace
+
+ConvexProxy ConvexProxy::fromShape(const Shape& shape, const glm::vec2& position) {
+    const std::vector<glm::vec2>& core = shape.getCore();
+    return {core.data(), static_cast<uint32_t>(core.size()), shape.getRadius(), position};
+}
+
+uint32_t ConvexProxy::support(const glm::vec2& direction) const {
+    uint32_t best = 0;
+    float bestProjection = glm::dot(points[0], direction);
+    for (uint32_t i = 1; i < count; i++) {
+        float projection = glm::dot(points[i], direction);
+        if (projection > bestProjection) {
+            bestProjection = projection;
+            best = i;
+        }
+    }
+    return best;
+}
+
+DistanceResult gjkDistance(const ConvexProxy& proxyA, const ConvexProxy& proxyB, SimplexCache& cache) {
+    Simplex simplex;
+    simplex.read(cache, proxyA, proxyB);
+
+    DistanceResult result;
+    result.iterations = 0;
+    result.overlap = false;
+
+    uint32_t savedA[3];
+    uint32_t savedB[3];
+    while (result.iterations < maxGjkIterations) {
+        // 记下当前顶点，新的支撑点和其中之一重复说明已经收敛
+        uint32_t savedCount = simplex.count;
+        for (uint32_t i = 0; i < savedCount; i++) {
+            savedA[i] = simplex.v[i].indexA;
+            savedB[i] = simplex.v[i].indexB;
+        }
+
+        if (simplex.count == 2) simplex.solve2();
+        else if (simplex.count == 3) simplex.solve3();
+
+        // 三角形包住原点：核心重叠
+        if (simplex.count == 3) {
+            result.overlap = true;
+            break;
+        }
+
+        // 原点落在单纯形上：核心刚好接触
+        glm::vec2 direction = simplex.searchDirection();
+        if (glm::dot(direction, direction) < degenerateEpsilon) {
+            result.overlap = true;
+            break;
+        }
+
+        SimplexVertex& vertex = simplex.v[simplex.count];
+        Simplex::setVertex(vertex, proxyA.support(-direction), proxyB.support(direction), proxyA, proxyB);
+        result.iterations++;
+
+        bool duplicate = false;
+        for (uint32_t i = 0; i < savedCount; i++) {
+            if (vertex.indexA == savedA[i] && vertex.indexB == savedB[i]) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) break;
+        simplex.count++;
+    }
+
+    simplex.witnessPoints(result.pointA, result.pointB);
+    result.distance = result.overlap ? 0.0f : glm::length(result.pointB - result.pointA);
+    simplex.write(cache);
+    return result;
+}
+
+bool epaPenetration(const ConvexProxy& proxyA, const ConvexProxy& proxyB, const SimplexCache& cache,
+                    PenetrationResult& out) {
+    PolytopeVertex polytope[maxPolytopeVertices];
+    uint32_t count = cache.count;
+    for (uint32_t i = 0; i < count; i++) {
+        polytope[i] = {proxyB.point(cache.indexB[i]) - proxyA.point(cache.indexA[i]), cache.indexA[i], cache.indexB[i]};
+    }
+    if (count < 2) return false;
+
+    // 原点在线段上：沿法线两侧找一个支撑点补成三角形
+    if (count == 2) {
+        glm::vec2 edge = polytope[1].w - polytope[0].w;
+        glm::vec2 normal(-edge.y, edge.x);
+        PolytopeVertex vertex = supportVertex(proxyA, proxyB, normal);
+        if (cross(edge, vertex.w - polytope[0].w) * cross(edge, vertex.w - polytope[0].w) < degenerateEpsilon) {
+            vertex = supportVertex(proxyA, proxyB, -normal);
+        }
+        polytope[count++] = vertex;
+    }
+
+    // 统一成逆时针
+    float area = cross(polytope[1].w - polytope[0].w, polytope[2].w - polytope[0].w);
+    if (std::abs(area) < degenerateEpsilon) return false;
+    if (area < 0.0f) std::swap(polytope[1], polytope[2]);
+
+    out.iterations = 0;
+    for (;;) {
+        // 离原点最近的边；逆时针时边 (x, y) 的外法线是 (y, -x)
+        uint32_t closest = 0;
+        float closestDistance = FLT_MAX;
+        glm::vec2 closestNormal(0.0f);
+        for (uint32_t i = 0; i < count; i++) {
+            glm::vec2 edge = polytope[(i + 1) % count].w - polytope[i].w;
+            float length = glm::length(edge);
+            if (length * length < degenerateEpsilon) continue;
+            glm::vec2 normal = glm::vec2(edge.y, -edge.x) / length;
+            float distance = glm::dot(normal, polytope[i].w);
+            if (distance < closestDistance) {
+                closestDistance = distance;
+                closest = i;
+                closestNormal = normal;
+            }
+        }
+
+        PolytopeVertex vertex = supportVertex(proxyA, proxyB, closestNormal);
+        out.iterations++;
+        bool converged = glm::dot(vertex.w, closestNormal) - closestDistance < epaTolerance;
+        if (converged || out.iterations >= maxEpaIterations || count == maxPolytopeVertices) {
+            // 闵可夫斯基差 B - A 的外法线指向 A 一侧，B 要反着它推开
+            const PolytopeVertex& v0 = polytope[closest];
+            const PolytopeVertex& v1 = polytope[(closest + 1) % count];
+            glm::vec2 edge = v1.w - v0.w;
+            float t = std::clamp(-glm::dot(v0.w, edge) / glm::dot(edge, edge), 0.0f, 1.0f);
+            out.normal = -closestNormal;
+            out.depth = std::max(closestDistance, 0.0f);
+            out.pointA = glm::mix(proxyA.point(v0.indexA), proxyA.point(v1.indexA), t);
+            out.pointB = glm::mix(proxyB.point(v0.indexB), proxyB.point(v1.indexB), t);
+            return true;
+        }
+
+        // 新顶点插在最近的边中间
+        uint32_t inserted = closest + 1;
+        for (uint32_t i = count; i > inserted; i--) polytope[i] = polytope[i - 1];
+        polytope[inserted] = vertex;
+        count++;
+
+        // 支撑点落在平的面上时可能取到面的另一端，让相邻顶点凹进去；去掉它们保持凸多边形
+        auto reflex = [&](uint32_t i) {
+            const glm::vec2& previous = polytope[(i + count - 1) % count].w;
+            const glm::vec2& next = polytope[(i + 1) % count].w;
+            return cross(polytope[i].w - previous, next - polytope[i].w) <= 0.0f;
+        };
+        auto erase = [&](uint32_t i) {
+            for (uint32_t j = i; j + 1 < count; j++) polytope[j] = polytope[j + 1];
+            count--;
+        };
+        while (count > 3 && reflex((inserted + count - 1) % count)) {
+            uint32_t previous = (inserted + count - 1) % count;
+            erase(previous);
+            if (previous < inserted) inserted--;
+        }
+        while (count > 3 && reflex((inserted + 1) % count)) {
+            uint32_t next = (inserted + 1) % count;
+            erase(next);
+            if (next < inserted) inserted--;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "ShapeLibrary.h"
+
+// Support-function view of a convex shape for GJK and EPA: the convex hull of `count` core
+// points, moved to `position` and inflated by `radius`. A circle is one point, a capsule two,
+// a rounded box four, a polygon its hull with radius 0.
+struct ConvexProxy {
+    const glm::vec2* points;
+    uint32_t count;
+    float radius;
+    glm::vec2 position;
+
+    static ConvexProxy fromShape(const Shape& shape, const glm::vec2& position);
+    // Index of the core point furthest along direction (the radius is left to the caller)
+    uint32_t support(const glm::vec2& direction) const;
+    glm::vec2 point(uint32_t index) const { return position + points[index]; }
+};
+
+// Simplex that GJK ended with, as indices of core points of both proxies. Kept per pair between
+// steps: bodies do not rotate, so last step's simplex is usually still the answer for a slowly
+// moving pair and GJK only has to confirm it.
+struct SimplexCache {
+    uint32_t count = 0;   // 0 starts cold from the first core points
+    uint32_t indexA[3];
+    uint32_t indexB[3];
+};
+
+struct DistanceResult {
+    glm::vec2 pointA;     // closest points of the two cores
+    glm::vec2 pointB;
+    float distance;       // between the cores, without the radii; 0 if they overlap
+    uint32_t iterations;  // support points evaluated
+    bool overlap;         // the cores overlap or touch
+};
+
+// GJK distance between the cores of two proxies. Starts from the simplex in cache and writes
+// the final one back, so that epaPenetration can continue from it.
+DistanceResult gjkDistance(const ConvexProxy& proxyA, const ConvexProxy& proxyB, SimplexCache& cache);
+
+struct PenetrationResult {
+    glm::vec2 normal;     // from A to B
+    float depth;          // of the cores, without the radii
+    glm::vec2 pointA;     // deepest points of the two cores
+    glm::vec2 pointB;
+    uint32_t iterations;
+};
+
+// EPA: grows the simplex gjkDistance left in cache (which must enclose the origin) into a
+// polygon of the Minkowski difference until the edge closest to the origin is on its boundary.
+// Returns false if the cores only touch and there is no area to expand.
+bool epaPenetration(const ConvexProxy& proxyA, const ConvexProxy& proxyB, const SimplexCache& cache,
+                    PenetrationResult& out);
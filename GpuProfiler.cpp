@@ -0,0 +1,173 @@
+#include "GpuProfiler.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+bool GpuProfiler::init(VkPhysicalDevice physicalDevice, VkDevice logicalDevice, uint32_t queueFamily, VkQueue graphicsQueue,
+                       VkCommandPool pool, uint32_t framesInFlight) {
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    if (queueFamily >= familyCount || families[queueFamily].timestampValidBits == 0) {
+        return false;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    nanosecondsPerTick = properties.limits.timestampPeriod;
+    uint32_t validBits = families[queueFamily].timestampValidBits;
+    tickMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    device = logicalDevice;
+    queue = graphicsQueue;
+    commandPool = pool;
+    calibrationQuery = framesInFlight * queriesPerFrame;
+
+    VkQueryPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = calibrationQuery + 1;
+    if (vkCreateQueryPool(device, &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+
+    frameZones.assign(framesInFlight, {});
+    traceTrack = Profiler::createTrack("GPU");
+    calibrate();
+    return true;
+}
+
+void GpuProfiler::destroy() {
+    if (queryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(device, queryPool, nullptr);
+        queryPool = VK_NULL_HANDLE;
+    }
+}
+
+void GpuProfiler::calibrate() {
+    if (!isSupported()) return;
+
+    VkCommandBufferAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = commandPool;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate calibration command buffer!");
+    }
+
+    // 提交前后各取一次 CPU 时间，取中点；重复几次，用间隔最短的一次
+    int64_t bestWindow = INT64_MAX;
+    for (int attempt = 0; attempt < 5; attempt++) {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        vkCmdResetQueryPool(commandBuffer, queryPool, calibrationQuery, 1);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, calibrationQuery);
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+
+        int64_t before = Profiler::now();
+        if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit calibration command buffer!");
+        }
+        vkQueueWaitIdle(queue);
+        int64_t after = Profiler::now();
+
+        uint64_t ticks = 0;
+        VkResult result = vkGetQueryPoolResults(device, queryPool, calibrationQuery, 1, sizeof(ticks), &ticks, sizeof(ticks),
+                                                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+        if (result == VK_SUCCESS && after - before < bestWindow) {
+            bestWindow = after - before;
+            calibrationTicks = ticks & tickMask;
+            calibrationCpuNs = before + (after - before) / 2;
+        }
+        vkResetCommandBuffer(commandBuffer, 0);
+    }
+    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+    if (!isSupported()) return;
+
+    currentFrame = frameIndex;
+    collect(frameIndex);
+    vkCmdResetQueryPool(commandBuffer, queryPool, frameIndex * queriesPerFrame, queriesPerFrame);
+}
+
+uint32_t GpuProfiler::beginZone(VkCommandBuffer commandBuffer, const char* name) {
+    if (!isSupported()) return invalidZone;
+
+    std::vector<Zone>& zones = frameZones[currentFrame];
+    if (zones.size() >= maxZonesPerFrame) return invalidZone;
+
+    uint32_t zone = static_cast<uint32_t>(zones.size());
+    zones.push_back({name, false});
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, currentFrame * queriesPerFrame + zone * 2);
+    return zone;
+}
+
+void GpuProfiler::endZone(VkCommandBuffer commandBuffer, uint32_t zone) {
+    if (!isSupported() || zone == invalidZone) return;
+
+    frameZones[currentFrame][zone].ended = true;
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, currentFrame * queriesPerFrame + zone * 2 + 1);
+}
+
+void GpuProfiler::collect(uint32_t frameIndex) {
+    std::vector<Zone>& zones = frameZones[frameIndex];
+    if (zones.empty()) return;
+
+    // 每个查询两个值：时间戳和可用标志。这一帧的 fence 已经等过，不带 WAIT 也不会阻塞
+    uint32_t queryCount = static_cast<uint32_t>(zones.size()) * 2;
+    std::vector<uint64_t> results(queryCount * 2);
+    vkGetQueryPoolResults(device, queryPool, frameIndex * queriesPerFrame, queryCount, results.size() * sizeof(uint64_t),
+                          results.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    for (size_t z = 0; z < zones.size(); z++) {
+        const uint64_t* begin = &results[z * 4];
+        const uint64_t* end = &results[z * 4 + 2];
+        if (!zones[z].ended || begin[1] == 0 || end[1] == 0) continue;
+
+        uint64_t ticks = (end[0] - begin[0]) & tickMask;
+        std::deque<double>& samples = history[zones[z].name];
+        samples.push_back(static_cast<double>(ticks) * nanosecondsPerTick / 1.0e6);
+        if (samples.size() > historySize) samples.pop_front();
+
+        if (Profiler::isEnabled()) {
+            Profiler::recordOnTrack(traceTrack, zones[z].name, toCpuNanoseconds(begin[0]), toCpuNanoseconds(end[0]));
+        }
+    }
+    zones.clear();
+}
+
+int64_t GpuProfiler::toCpuNanoseconds(uint64_t ticks) const {
+    // 时间戳只有 timestampValidBits 位，按回绕后的差值换算，超过一半视为在校准之前
+    uint64_t delta = (ticks - calibrationTicks) & tickMask;
+    double signedDelta = delta > tickMask / 2 ? -static_cast<double>((calibrationTicks - ticks) & tickMask)
+                                              : static_cast<double>(delta);
+    return calibrationCpuNs + static_cast<int64_t>(signedDelta * nanosecondsPerTick);
+}
+
+GpuProfiler::Stats GpuProfiler::getStats(const std::string& name) const {
+    Stats stats;
+    auto found = history.find(name);
+    if (found == history.end() || found->second.empty()) return stats;
+
+    const std::deque<double>& samples = found->second;
+    stats.samples = samples.size();
+    stats.minMs = *std::min_element(samples.begin(), samples.end());
+    stats.maxMs = *std::max_element(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) sum += sample;
+    stats.averageMs = sum / static_cast<double>(samples.size());
+    return stats;
+}
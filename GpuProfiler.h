@@ -0,0 +1,71 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// GPU timestamp zones. Each frame in flight owns a range of a timestamp query pool; a range is
+// read back when its frame slot comes round again, after that slot's fence wait, so reading never
+// stalls. Zones are kept as rolling statistics and, while the Profiler is enabled, written to a
+// "GPU" track of the CPU trace with timestamps converted to Profiler::now().
+class GpuProfiler {
+public:
+    static constexpr uint32_t maxZonesPerFrame = 16;
+    static constexpr size_t historySize = 120;   // frames kept per zone for the statistics
+    static constexpr uint32_t invalidZone = ~0u;
+
+    struct Stats {
+        double averageMs = 0.0;
+        double minMs = 0.0;
+        double maxMs = 0.0;
+        size_t samples = 0;
+    };
+
+    // Returns false, leaving every other call a no-op, if the queue family cannot write timestamps.
+    // Calibrates against the CPU clock by submitting to the queue and waiting for it.
+    bool init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamily, VkQueue queue,
+              VkCommandPool commandPool, uint32_t framesInFlight);
+    void destroy();
+    bool isSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+    // Call first in the frame's command buffer, outside a render pass, once the frame's fence
+    // has been waited on
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    // `name` must outlive the profiler (normally a string literal)
+    uint32_t beginZone(VkCommandBuffer commandBuffer, const char* name);
+    void endZone(VkCommandBuffer commandBuffer, uint32_t zone);
+
+    Stats getStats(const std::string& name) const;
+
+    // Measures the offset between GPU ticks and Profiler::now() again. Waits for the queue.
+    void calibrate();
+
+private:
+    struct Zone {
+        const char* name;
+        bool ended;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    uint32_t queriesPerFrame = 2 * maxZonesPerFrame;
+    uint32_t calibrationQuery = 0;   // the last query of the pool
+    double nanosecondsPerTick = 1.0;
+    uint64_t tickMask = ~0ull;       // timestampValidBits of the queue family
+
+    // Clock correlation: GPU tick value that was current at CPU time calibrationCpuNs
+    uint64_t calibrationTicks = 0;
+    int64_t calibrationCpuNs = 0;
+    uint32_t traceTrack = ~0u;
+
+    uint32_t currentFrame = 0;
+    std::vector<std::vector<Zone>> frameZones;    // zones written in each frame slot's last use
+    std::map<std::string, std::deque<double>> history;
+
+    void collect(uint32_t frameIndex);
+    int64_t toCpuNanoseconds(uint64_t ticks) const;
+};
@@ -0,0 +1,247 @@
+#include "InstanceBatcher.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+namespace {
+
+constexpr uint32_t instanceGrainSize = 4096;
+constexpr uint32_t deformedGrainSize = 64;
+constexpr uint32_t white = 0xFFFFFFFFu;
+
+bool hasUniformColor(const Shape& shape) {
+    const std::vector<BodyVertex>& vertices = shape.getVertices();
+    for (const auto& vertex : vertices) {
+        if (vertex.color != vertices[0].color) return false;
+    }
+    return !vertices.empty();
+}
+
+// FNV-1a over the vertex positions only
+uint64_t hashPositions(const Shape& shape) {
+    uint64_t hash = 1469598103934665603ull;
+    for (const auto& vertex : shape.getVertices()) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex.position);
+        for (size_t i = 0; i < sizeof(vertex.position); i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+bool samePositions(const Shape& a, const Shape& b) {
+    const std::vector<BodyVertex>& va = a.getVertices();
+    const std::vector<BodyVertex>& vb = b.getVertices();
+    if (va.size() != vb.size()) return false;
+    for (size_t i = 0; i < va.size(); i++) {
+        if (va[i].position != vb[i].position) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+InstanceBatcher::InstanceBatcher(JobSystem& jobSystem, uint32_t regionCount, VertexFormat vertexFormat)
+    : jobs(jobSystem), format(vertexFormat), vertexStride(getVertexStride(vertexFormat)), regions(regionCount) {
+    // 还没有物体时只有变形物体的绘制
+    draws.push_back({0, 0, 0, 1});
+    instanceCount = 1;
+}
+
+bool InstanceBatcher::update(const RenderSnapshot& snapshot) {
+    uint64_t previousMeshVersion = meshVersion;
+    if (bodyListVersion != snapshot.bodyListVersion) {
+        regroup(snapshot);
+        bodyListVersion = snapshot.bodyListVersion;
+    }
+
+    // 变形物体的顶点接在网格后面，用最后一个实例画
+    deformedVertexCount = snapshot.deformedVertices.size();
+    InstanceDraw& deformedDraw = draws.back();
+    deformedDraw.firstVertex = static_cast<uint32_t>(meshVertexCount);
+    deformedDraw.vertexCount = static_cast<uint32_t>(deformedVertexCount);
+    return meshVersion != previousMeshVersion;
+}
+
+void InstanceBatcher::regroup(const RenderSnapshot& snapshot) {
+    PROFILE_ZONE("regroup instances");
+    const uint32_t bodyCount = static_cast<uint32_t>(snapshot.shapes.size());
+
+    // 按第一次出现的顺序给网格编号，同时数出每个网格有多少个物体。
+    // 单色形状按几何分组，颜色放进实例；多色形状保留自己的网格
+    std::unordered_map<const Shape*, ShapeMesh> shapeMeshes;
+    std::unordered_multimap<uint64_t, uint32_t> tintedMeshes;
+    std::vector<MeshSource> sources;
+    std::vector<uint32_t> bodyMesh(bodyCount);
+    std::vector<uint32_t> meshBodies;
+    bodyColors.resize(bodyCount);
+    for (uint32_t i = 0; i < bodyCount; i++) {
+        const ShapeRef& shape = snapshot.shapes[i];
+        auto inserted = shapeMeshes.emplace(shape.get(), ShapeMesh{0, white});
+        ShapeMesh& shapeMesh = inserted.first->second;
+        if (inserted.second) {
+            bool tinted = hasUniformColor(*shape);
+            uint32_t mesh = static_cast<uint32_t>(sources.size());
+            if (tinted) {
+                shapeMesh.color = packColor(shape->getVertices()[0].color);
+                uint64_t hash = hashPositions(*shape);
+                auto range = tintedMeshes.equal_range(hash);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (samePositions(*sources[it->second].shape, *shape)) {
+                        mesh = it->second;
+                        break;
+                    }
+                }
+                if (mesh == sources.size()) tintedMeshes.emplace(hash, mesh);
+            }
+            if (mesh == sources.size()) {
+                sources.push_back({shape, tinted});
+                meshBodies.push_back(0);
+            }
+            shapeMesh.mesh = mesh;
+        }
+        bodyMesh[i] = shapeMesh.mesh;
+        bodyColors[i] = shapeMesh.color;
+        meshBodies[bodyMesh[i]]++;
+    }
+
+    // 网格集合没变时保持不动，不必重新上传
+    if (sources != meshSources) {
+        meshSources = std::move(sources);
+        meshVertexCount = 0;
+        for (const auto& source : meshSources) {
+            meshVertexCount += source.shape->getVertices().size();
+        }
+        meshData.resize(meshVertexCount * vertexStride);
+        size_t offset = 0;
+        std::vector<BodyVertex> whiteVertices;
+        for (const auto& source : meshSources) {
+            const std::vector<BodyVertex>* vertices = &source.shape->getVertices();
+            // 着色网格存成白色，由实例颜色相乘得到物体颜色
+            if (source.tinted) {
+                whiteVertices = *vertices;
+                for (auto& vertex : whiteVertices) vertex.color = glm::vec3(1.0f);
+                vertices = &whiteVertices;
+            }
+            encodeVertices(format, vertices->data(), vertices->size(), glm::vec2(0.0f), meshData.data() + offset);
+            offset += vertices->size() * vertexStride;
+        }
+        meshVersion++;
+    }
+
+    // 计数排序：同一形状的物体占连续的实例
+    draws.assign(meshSources.size() + 1, InstanceDraw{0, 0, 0, 0});
+    uint32_t firstVertex = 0;
+    uint32_t firstInstance = 0;
+    for (size_t m = 0; m < meshSources.size(); m++) {
+        uint32_t vertexCount = static_cast<uint32_t>(meshSources[m].shape->getVertices().size());
+        draws[m] = {firstVertex, vertexCount, firstInstance, meshBodies[m]};
+        firstVertex += vertexCount;
+        firstInstance += meshBodies[m];
+    }
+    draws.back() = {firstVertex, 0, firstInstance, 1};
+
+    instanceSlots.resize(bodyCount);
+    std::vector<uint32_t> nextSlot(meshSources.size());
+    for (size_t m = 0; m < meshSources.size(); m++) {
+        nextSlot[m] = draws[m].firstInstance;
+    }
+    for (uint32_t i = 0; i < bodyCount; i++) {
+        instanceSlots[i] = nextSlot[bodyMesh[i]]++;
+    }
+    instanceCount = bodyCount + 1;
+    layoutVersion++;
+}
+
+void InstanceBatcher::invalidate() {
+    for (auto& region : regions) {
+        region.layoutVersion = ~0ull;
+    }
+}
+
+InstanceRange InstanceBatcher::writeInstances(const RenderSnapshot& snapshot, float alpha, uint32_t regionIndex, BodyInstance* out) {
+    PROFILE_ZONE("write instances");
+    const uint32_t bodyCount = static_cast<uint32_t>(instanceSlots.size());
+    const float scale = getPositionScale(format);
+
+    // 实例的排列变了，这个区域里的内容全部作废
+    Region& region = regions[regionIndex];
+    bool rewriteAll = region.layoutVersion != layoutVersion;
+    if (rewriteAll) {
+        region.instances.resize(instanceCount);
+        region.layoutVersion = layoutVersion;
+    }
+
+    // 每块记下自己改写的实例范围，最后合并
+    const uint32_t chunkCount = (bodyCount + instanceGrainSize - 1) / instanceGrainSize;
+    chunkRanges.assign(chunkCount, InstanceRange{UINT32_MAX, 0});
+    std::atomic<size_t> rewritten{0};
+    jobs.parallelFor(bodyCount, instanceGrainSize, [&](uint32_t begin, uint32_t end) {
+        size_t nextDeformed = std::lower_bound(snapshot.deformedBodies.begin(), snapshot.deformedBodies.end(), begin) -
+                              snapshot.deformedBodies.begin();
+        InstanceRange range = {UINT32_MAX, 0};
+        size_t chunkRewritten = 0;
+        for (uint32_t i = begin; i < end; i++) {
+            glm::vec2 position = alpha >= 1.0f ? snapshot.positions[i]
+                                               : glm::mix(snapshot.previousPositions[i], snapshot.positions[i], alpha);
+            // 变形物体由单独的绘制调用画，这里把它的实例缩成一点
+            bool isDeformed = nextDeformed < snapshot.deformedBodies.size() && snapshot.deformedBodies[nextDeformed] == i;
+            if (isDeformed) nextDeformed++;
+            BodyInstance instance = {position, isDeformed ? 0.0f : scale, bodyColors[i]};
+
+            // 区域里已经是这个值的实例不用再写
+            uint32_t slot = instanceSlots[i];
+            BodyInstance& held = region.instances[slot];
+            if (!rewriteAll && held.position == instance.position && held.scale == instance.scale && held.color == instance.color) {
+                continue;
+            }
+            held = instance;
+            out[slot] = instance;
+            range.first = std::min(range.first, slot);
+            range.end = std::max(range.end, slot + 1);
+            chunkRewritten++;
+        }
+        // 单线程时整段一次处理完，begin 为 0
+        chunkRanges[begin / instanceGrainSize] = range;
+        rewritten.fetch_add(chunkRewritten, std::memory_order_relaxed);
+    });
+
+    InstanceRange written = {UINT32_MAX, 0};
+    for (const InstanceRange& range : chunkRanges) {
+        written.first = std::min(written.first, range.first);
+        written.end = std::max(written.end, range.end);
+    }
+    rewrittenCount = rewritten.load(std::memory_order_relaxed);
+
+    // 变形绘制用的单位实例只在重新排列后写一次
+    if (rewriteAll) {
+        BodyInstance identity = {glm::vec2(0.0f), scale, white};
+        region.instances[bodyCount] = identity;
+        out[bodyCount] = identity;
+        written.first = std::min(written.first, bodyCount);
+        written.end = bodyCount + 1;
+        rewrittenCount++;
+    }
+    if (written.first >= written.end) written = {0, 0};
+    return written;
+}
+
+void InstanceBatcher::writeDeformedVertices(const RenderSnapshot& snapshot, float alpha, void* out) const {
+    PROFILE_ZONE("write deformed vertices");
+    char* target = static_cast<char*>(out);
+    const uint32_t deformedCount = static_cast<uint32_t>(snapshot.deformedBodies.size());
+
+    // 偏移是快照里按物体顺序累加的前缀和，各块直接写到映射内存里各自的位置
+    jobs.parallelFor(deformedCount, deformedGrainSize, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t k = begin; k < end; k++) {
+            uint32_t i = snapshot.deformedBodies[k];
+            // 变形后的顶点是按当前位置生成的，整体平移到插值位置
+            glm::vec2 offset = alpha >= 1.0f ? glm::vec2(0.0f)
+                                             : glm::mix(snapshot.previousPositions[i], snapshot.positions[i], alpha) - snapshot.positions[i];
+            size_t first = snapshot.deformedOffsets[k];
+            size_t last = k + 1 < deformedCount ? snapshot.deformedOffsets[k + 1] : snapshot.deformedVertices.size();
+            encodeVertices(format, snapshot.deformedVertices.data() + first, last - first, offset, target + first * vertexStride);
+        }
+    });
+}
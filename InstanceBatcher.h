@@ -0,0 +1,121 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "JobSystem.h"
+#include "SimulationThread.h"
+#include "VertexFormat.h"
+
+// Per-instance input of the instanced draw path (vertex binding 1)
+struct BodyInstance {
+    glm::vec2 position;
+    float scale;        // getPositionScale() of the vertex format; 0 collapses the triangles, hiding it
+    uint32_t color;     // RGBA8 tint multiplied into the mesh colour: the body's colour on white meshes
+};
+
+// Instances [first, end) rewritten by one writeInstances call; empty when first == end
+struct InstanceRange {
+    uint32_t first;
+    uint32_t end;
+};
+
+// One instanced draw: vertices of a mesh, drawn once per instance
+struct InstanceDraw {
+    uint32_t firstVertex;
+    uint32_t vertexCount;
+    uint32_t firstInstance;
+    uint32_t instanceCount;
+};
+
+// Turns a RenderSnapshot into instanced draws. Every mesh in use gets its local-space vertices
+// into a mesh list once, and bodies are grouped by mesh so each mesh is drawn with one draw call;
+// per frame only a small instance per body is written instead of every translated vertex.
+// Single-coloured shapes share a white mesh per geometry and carry their colour in the instance,
+// so the same geometry in different colours is one draw; shapes with per-vertex colours keep
+// their own mesh with a white instance.
+//
+// Instances are written straight into caller-owned memory (normally a mapped buffer) split into
+// regions, one per frame in flight, that keep their contents between writes. For every region the
+// batcher remembers what each instance holds and only rewrites the ones that changed, so resting
+// bodies cost one compare per frame.
+//
+// Deformed bodies no longer match their shape. Their instance is hidden and their world-space
+// vertices, written after the meshes, are drawn by one extra draw with an identity instance.
+// Meshes and deformed vertices are encoded in the vertex format given at construction.
+class InstanceBatcher {
+public:
+    InstanceBatcher(JobSystem& jobs, uint32_t regionCount, VertexFormat format = VertexFormat::Float);
+
+    VertexFormat getVertexFormat() const { return format; }
+
+    // Call once per frame. Regroups the bodies when the body list changed and sizes the draw of
+    // the deformed bodies. Returns true if the mesh vertices changed.
+    bool update(const RenderSnapshot& snapshot);
+
+    // Local-space vertices of every shape in use, back to back, encoded in the vertex format
+    const std::vector<uint8_t>& getMeshData() const { return meshData; }
+    size_t getMeshVertexCount() const { return meshVertexCount; }
+    // Incremented whenever the mesh data changes
+    uint64_t getMeshVersion() const { return meshVersion; }
+    // Deformed vertices to write after the meshes
+    size_t getDeformedVertexCount() const { return deformedVertexCount; }
+    // One instance per body plus the identity instance of the deformed draw
+    size_t getInstanceCount() const { return instanceCount; }
+    const std::vector<InstanceDraw>& getDraws() const { return draws; }
+
+    // Brings the getInstanceCount() instances of `region` up to date, bodies placed at
+    // previous + alpha * (current - previous). `out` must be the same memory on every call for the
+    // same region. Returns the range that was rewritten, which is all that needs uploading.
+    InstanceRange writeInstances(const RenderSnapshot& snapshot, float alpha, uint32_t region, BodyInstance* out);
+    // Forgets what the regions hold, e.g. after their memory was replaced
+    void invalidate();
+    // Instances rewritten by the last writeInstances()
+    size_t getRewrittenCount() const { return rewrittenCount; }
+
+    // Writes getDeformedVertexCount() encoded world-space vertices, placed like writeInstances().
+    // Each body goes to its offset in the snapshot's deformed vertex prefix sum, in parallel.
+    void writeDeformedVertices(const RenderSnapshot& snapshot, float alpha, void* out) const;
+
+private:
+    // Shape whose vertices a mesh holds; tinted meshes are stored white
+    struct MeshSource {
+        ShapeRef shape;
+        bool tinted;
+
+        bool operator==(const MeshSource& other) const { return shape == other.shape && tinted == other.tinted; }
+        bool operator!=(const MeshSource& other) const { return !(*this == other); }
+    };
+
+    struct ShapeMesh {
+        uint32_t mesh;
+        uint32_t color;
+    };
+
+    // What the instances of one output region hold
+    struct Region {
+        uint64_t layoutVersion = ~0ull;
+        std::vector<BodyInstance> instances;
+    };
+
+    JobSystem& jobs;
+    VertexFormat format;
+    size_t vertexStride;
+
+    uint64_t bodyListVersion = ~0ull;
+    std::vector<MeshSource> meshSources;    // in mesh order; keeps the shapes alive while drawn
+    std::vector<uint32_t> bodyColors;       // instance colour per body row
+    std::vector<uint8_t> meshData;
+    size_t meshVertexCount = 0;
+    uint64_t meshVersion = 0;
+
+    std::vector<uint32_t> instanceSlots;    // instanceSlots[body] = its instance
+    std::vector<InstanceDraw> draws;        // one per mesh, then the deformed draw
+    size_t instanceCount = 0;
+    size_t deformedVertexCount = 0;
+    uint64_t layoutVersion = 0;             // bumped by every regroup, which moves instances
+    std::vector<Region> regions;
+    std::vector<InstanceRange> chunkRanges;
+    size_t rewrittenCount = 0;
+
+    void regroup(const RenderSnapshot& snapshot);
+};
@@ -0,0 +1,262 @@
+#include "Integrator.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define INTEGRATOR_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define INTEGRATOR_TARGET(isa)
+#else
+#define INTEGRATOR_TARGET(isa) __attribute__((target(isa)))
+#endif
+#else
+#define INTEGRATOR_X86 0
+#endif
+
+namespace {
+
+// 标量版本，也是向量版本处理剩余物体时用的参考实现
+void integrateScalar(BodyStore& bodies, uint32_t begin, uint32_t end, const IntegratorParams& params) {
+    glm::vec2* positions = bodies.positions.data();
+    glm::vec2* velocities = bodies.velocities.data();
+    glm::vec2* accelerations = bodies.accelerations.data();
+    const float* masses = bodies.masses.data();
+    const float* inverseMasses = bodies.inverseMasses.data();
+    const float* elasticities = bodies.elasticities.data();
+    const float* frictions = bodies.frictions.data();
+
+    for (uint32_t i = begin; i < end; i++) {
+        // 应用重力和空气阻力
+        glm::vec2 weight = params.gravity * masses[i];
+        glm::vec2 resistance = -velocities[i] * params.airResistance;
+        accelerations[i] += (weight + resistance) * inverseMasses[i];
+
+        // 更新速度和位置
+        velocities[i] += accelerations[i] * params.deltaTime;
+        positions[i] += velocities[i] * params.deltaTime;
+
+        // 重置加速度
+        accelerations[i] = glm::vec2(0.0f);
+
+        // 检查是否与地面碰撞
+        if (positions[i].y < params.groundLevel) {
+            positions[i].y = params.groundLevel;
+
+            // 应用反弹和摩擦力；速度太小时直接停下，不做微小的反弹
+            velocities[i].y = -velocities[i].y > params.bounceThreshold ? -velocities[i].y * elasticities[i] : 0.0f;
+            velocities[i].x *= (1.0f - frictions[i]);
+        }
+    }
+}
+
+#if INTEGRATOR_X86
+
+// 注意：不能开启 FMA，乘加融合会改变舍入，结果就和标量版本不一致了
+
+// x,y 交错的 vec2 数组，每次处理 4 个物体：拆成 x 和 y 两个寄存器
+INTEGRATOR_TARGET("sse4.1")
+void integrateSSE4(BodyStore& bodies, uint32_t begin, uint32_t end, const IntegratorParams& params) {
+    float* positions = reinterpret_cast<float*>(bodies.positions.data());
+    float* velocities = reinterpret_cast<float*>(bodies.velocities.data());
+    float* accelerations = reinterpret_cast<float*>(bodies.accelerations.data());
+    const float* masses = bodies.masses.data();
+    const float* inverseMasses = bodies.inverseMasses.data();
+    const float* elasticities = bodies.elasticities.data();
+    const float* frictions = bodies.frictions.data();
+
+    const __m128 gravityX = _mm_set1_ps(params.gravity.x);
+    const __m128 gravityY = _mm_set1_ps(params.gravity.y);
+    const __m128 air = _mm_set1_ps(params.airResistance);
+    const __m128 dt = _mm_set1_ps(params.deltaTime);
+    const __m128 ground = _mm_set1_ps(params.groundLevel);
+    const __m128 bounceThreshold = _mm_set1_ps(params.bounceThreshold);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        float* p = positions + 2 * i;
+        float* v = velocities + 2 * i;
+        float* a = accelerations + 2 * i;
+
+        __m128 p0 = _mm_loadu_ps(p), p1 = _mm_loadu_ps(p + 4);
+        __m128 v0 = _mm_loadu_ps(v), v1 = _mm_loadu_ps(v + 4);
+        __m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4);
+        __m128 px = _mm_shuffle_ps(p0, p1, 0x88), py = _mm_shuffle_ps(p0, p1, 0xDD);
+        __m128 vx = _mm_shuffle_ps(v0, v1, 0x88), vy = _mm_shuffle_ps(v0, v1, 0xDD);
+        __m128 ax = _mm_shuffle_ps(a0, a1, 0x88), ay = _mm_shuffle_ps(a0, a1, 0xDD);
+
+        __m128 mass = _mm_loadu_ps(masses + i);
+        __m128 invMass = _mm_loadu_ps(inverseMasses + i);
+
+        // 应用重力和空气阻力
+        __m128 fx = _mm_add_ps(_mm_mul_ps(gravityX, mass), _mm_mul_ps(_mm_xor_ps(vx, signBit), air));
+        __m128 fy = _mm_add_ps(_mm_mul_ps(gravityY, mass), _mm_mul_ps(_mm_xor_ps(vy, signBit), air));
+        ax = _mm_add_ps(ax, _mm_mul_ps(fx, invMass));
+        ay = _mm_add_ps(ay, _mm_mul_ps(fy, invMass));
+
+        // 更新速度和位置
+        vx = _mm_add_ps(vx, _mm_mul_ps(ax, dt));
+        vy = _mm_add_ps(vy, _mm_mul_ps(ay, dt));
+        px = _mm_add_ps(px, _mm_mul_ps(vx, dt));
+        py = _mm_add_ps(py, _mm_mul_ps(vy, dt));
+
+        // 地面碰撞：只改写低于地面的物体
+        __m128 hit = _mm_cmplt_ps(py, ground);
+        __m128 elasticity = _mm_loadu_ps(elasticities + i);
+        __m128 friction = _mm_loadu_ps(frictions + i);
+        py = _mm_blendv_ps(py, ground, hit);
+        __m128 bounces = _mm_cmpgt_ps(_mm_xor_ps(vy, signBit), bounceThreshold);
+        __m128 bounce = _mm_and_ps(_mm_mul_ps(_mm_xor_ps(vy, signBit), elasticity), bounces);
+        vy = _mm_blendv_ps(vy, bounce, hit);
+        vx = _mm_blendv_ps(vx, _mm_mul_ps(vx, _mm_sub_ps(one, friction)), hit);
+
+        _mm_storeu_ps(p, _mm_unpacklo_ps(px, py));
+        _mm_storeu_ps(p + 4, _mm_unpackhi_ps(px, py));
+        _mm_storeu_ps(v, _mm_unpacklo_ps(vx, vy));
+        _mm_storeu_ps(v + 4, _mm_unpackhi_ps(vx, vy));
+        _mm_storeu_ps(a, zero);
+        _mm_storeu_ps(a + 4, zero);
+    }
+
+    integrateScalar(bodies, i, end, params);
+}
+
+// 读 8 个逐物体的标量，排成和拆开后的 vec2 相同的顺序 [0 1 4 5 | 2 3 6 7]
+INTEGRATOR_TARGET("avx2")
+inline __m256 loadPerBody(const float* values) {
+    __m256d raw = _mm256_castps_pd(_mm256_loadu_ps(values));
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(raw, 0xD8));
+}
+
+// 每次处理 8 个物体。shuffle 在两个 128 位半边内各自进行，拆开的 x 和 y 是乱序的，
+// 但所有数组用同一个顺序，写回时 unpack 正好还原
+INTEGRATOR_TARGET("avx2")
+void integrateAVX2(BodyStore& bodies, uint32_t begin, uint32_t end, const IntegratorParams& params) {
+    float* positions = reinterpret_cast<float*>(bodies.positions.data());
+    float* velocities = reinterpret_cast<float*>(bodies.velocities.data());
+    float* accelerations = reinterpret_cast<float*>(bodies.accelerations.data());
+    const float* masses = bodies.masses.data();
+    const float* inverseMasses = bodies.inverseMasses.data();
+    const float* elasticities = bodies.elasticities.data();
+    const float* frictions = bodies.frictions.data();
+
+    const __m256 gravityX = _mm256_set1_ps(params.gravity.x);
+    const __m256 gravityY = _mm256_set1_ps(params.gravity.y);
+    const __m256 air = _mm256_set1_ps(params.airResistance);
+    const __m256 dt = _mm256_set1_ps(params.deltaTime);
+    const __m256 ground = _mm256_set1_ps(params.groundLevel);
+    const __m256 bounceThreshold = _mm256_set1_ps(params.bounceThreshold);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    uint32_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        float* p = positions + 2 * i;
+        float* v = velocities + 2 * i;
+        float* a = accelerations + 2 * i;
+
+        __m256 p0 = _mm256_loadu_ps(p), p1 = _mm256_loadu_ps(p + 8);
+        __m256 v0 = _mm256_loadu_ps(v), v1 = _mm256_loadu_ps(v + 8);
+        __m256 a0 = _mm256_loadu_ps(a), a1 = _mm256_loadu_ps(a + 8);
+        __m256 px = _mm256_shuffle_ps(p0, p1, 0x88), py = _mm256_shuffle_ps(p0, p1, 0xDD);
+        __m256 vx = _mm256_shuffle_ps(v0, v1, 0x88), vy = _mm256_shuffle_ps(v0, v1, 0xDD);
+        __m256 ax = _mm256_shuffle_ps(a0, a1, 0x88), ay = _mm256_shuffle_ps(a0, a1, 0xDD);
+
+        __m256 mass = loadPerBody(masses + i);
+        __m256 invMass = loadPerBody(inverseMasses + i);
+
+        // 应用重力和空气阻力
+        __m256 fx = _mm256_add_ps(_mm256_mul_ps(gravityX, mass), _mm256_mul_ps(_mm256_xor_ps(vx, signBit), air));
+        __m256 fy = _mm256_add_ps(_mm256_mul_ps(gravityY, mass), _mm256_mul_ps(_mm256_xor_ps(vy, signBit), air));
+        ax = _mm256_add_ps(ax, _mm256_mul_ps(fx, invMass));
+        ay = _mm256_add_ps(ay, _mm256_mul_ps(fy, invMass));
+
+        // 更新速度和位置
+        vx = _mm256_add_ps(vx, _mm256_mul_ps(ax, dt));
+        vy = _mm256_add_ps(vy, _mm256_mul_ps(ay, dt));
+        px = _mm256_add_ps(px, _mm256_mul_ps(vx, dt));
+        py = _mm256_add_ps(py, _mm256_mul_ps(vy, dt));
+
+        // 地面碰撞：只改写低于地面的物体
+        __m256 hit = _mm256_cmp_ps(py, ground, _CMP_LT_OQ);
+        __m256 elasticity = loadPerBody(elasticities + i);
+        __m256 friction = loadPerBody(frictions + i);
+        py = _mm256_blendv_ps(py, ground, hit);
+        __m256 bounces = _mm256_cmp_ps(_mm256_xor_ps(vy, signBit), bounceThreshold, _CMP_GT_OQ);
+        __m256 bounce = _mm256_and_ps(_mm256_mul_ps(_mm256_xor_ps(vy, signBit), elasticity), bounces);
+        vy = _mm256_blendv_ps(vy, bounce, hit);
+        vx = _mm256_blendv_ps(vx, _mm256_mul_ps(vx, _mm256_sub_ps(one, friction)), hit);
+
+        _mm256_storeu_ps(p, _mm256_unpacklo_ps(px, py));
+        _mm256_storeu_ps(p + 8, _mm256_unpackhi_ps(px, py));
+        _mm256_storeu_ps(v, _mm256_unpacklo_ps(vx, vy));
+        _mm256_storeu_ps(v + 8, _mm256_unpackhi_ps(vx, vy));
+        _mm256_storeu_ps(a, zero);
+        _mm256_storeu_ps(a + 8, zero);
+    }
+
+    integrateScalar(bodies, i, end, params);
+}
+
+#endif // INTEGRATOR_X86
+
+} // namespace
+
+SimdLevel detectSimdLevel() {
+#if INTEGRATOR_X86
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+    // 操作系统要保存 YMM 寄存器才能用 AVX
+    bool ymmEnabled = osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+    if (avx2 && ymmEnabled) return SimdLevel::AVX2;
+    if (sse41) return SimdLevel::SSE4;
+#else
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return SimdLevel::SSE4;
+#endif
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char* toString(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::SSE4:
+        return "SSE4";
+    case SimdLevel::AVX2:
+        return "AVX2";
+    }
+    return "unknown";
+}
+
+void integrateBodies(BodyStore& bodies, uint32_t begin, uint32_t end, const IntegratorParams& params, SimdLevel level) {
+#if INTEGRATOR_X86
+    switch (level) {
+    case SimdLevel::AVX2:
+        integrateAVX2(bodies, begin, end, params);
+        return;
+    case SimdLevel::SSE4:
+        integrateSSE4(bodies, begin, end, params);
+        return;
+    case SimdLevel::Scalar:
+        break;
+    }
+#endif
+    integrateScalar(bodies, begin, end, params);
+}
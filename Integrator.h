@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "BodyStore.h"
+
+// Instruction set used by the body integrator. Every level produces bit-identical results:
+// the vector kernels do the same IEEE operations in the same order as the scalar one (no FMA).
+enum class SimdLevel {
+    Scalar,
+    SSE4, // 4 bodies per instruction
+    AVX2  // 8 bodies per instruction
+};
+
+struct IntegratorParams {
+    glm::vec2 gravity;
+    float airResistance;
+    float groundLevel;
+    float deltaTime;
+    float bounceThreshold = 0.0f; // bodies hitting the ground slower than this stop instead of bouncing
+};
+
+// Best level supported by this CPU and OS
+SimdLevel detectSimdLevel();
+const char* toString(SimdLevel level);
+
+// Gravity and linear air drag, velocity/position update and ground-plane response for
+// bodies [begin, end). Accelerations are consumed and reset to zero.
+void integrateBodies(BodyStore& bodies, uint32_t begin, uint32_t end, const IntegratorParams& params, SimdLevel level);
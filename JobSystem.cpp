@@ -0,0 +1,195 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <stdexcept>
+
+namespace {
+
+// 当前线程属于哪个 JobSystem 以及它的队列编号
+thread_local const JobSystem* currentSystem = nullptr;
+thread_local unsigned currentIndex = 0;
+
+// 空转这么多次还没有任务才去睡眠，避免每个小任务都要唤醒线程
+constexpr int spinCount = 256;
+
+} // namespace
+
+// TaskGraph 实现
+TaskGraph::TaskId TaskGraph::addTask(std::function<void()> fn) {
+    tasks.push_back({std::move(fn), {}, 0});
+    return static_cast<TaskId>(tasks.size() - 1);
+}
+
+void TaskGraph::addDependency(TaskId task, TaskId dependsOn) {
+    tasks[dependsOn].successors.push_back(task);
+    tasks[task].dependencyCount++;
+}
+
+void TaskGraph::clear() {
+    tasks.clear();
+}
+
+// JobSystem 实现
+unsigned JobSystem::getDefaultThreadCount() {
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+JobSystem::JobSystem(unsigned count) : threadCount(count > 0 ? count : getDefaultThreadCount()) {
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    // 线程 0 是调用者自己
+    for (unsigned i = 1; i < threadCount; i++) {
+        workers.emplace_back(&JobSystem::workerMain, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned JobSystem::currentQueue() const {
+    return currentSystem == this ? currentIndex : 0;
+}
+
+void JobSystem::submit(std::function<void()> fn, Counter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+    WorkerQueue& queue = *queues[currentQueue()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back({std::move(fn), &counter});
+    }
+
+    // 在锁内增加计数，保证睡眠中的线程不会错过唤醒
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+    wakeCondition.notify_one();
+}
+
+bool JobSystem::popJob(unsigned self, Job& job) {
+    // 自己的队列从尾部取，最近提交的数据还在缓存里
+    WorkerQueue& queue = *queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    return true;
+}
+
+bool JobSystem::stealJob(unsigned self, Job& job) {
+    // 从其他线程队列的头部偷最早的任务
+    for (unsigned offset = 1; offset < threadCount; offset++) {
+        WorkerQueue& queue = *queues[(self + offset) % threadCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) continue;
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::runOneJob(unsigned self) {
+    if (queuedJobs.load(std::memory_order_relaxed) == 0) return false;
+
+    Job job;
+    if (!popJob(self, job) && !stealJob(self, job)) return false;
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+
+    {
+        PROFILE_ZONE("job");
+        job.fn();
+    }
+    job.counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobSystem::wait(Counter& counter) {
+    unsigned self = currentQueue();
+    while (!counter.done()) {
+        // 等待时帮忙执行任务
+        if (!runOneJob(self)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::workerMain(unsigned index) {
+    currentSystem = this;
+    currentIndex = index;
+    Profiler::setThreadName("worker " + std::to_string(index));
+
+    for (;;) {
+        bool ranJob = false;
+        for (int spin = 0; spin < spinCount && !ranJob; spin++) {
+            ranJob = runOneJob(index);
+            if (!ranJob) std::this_thread::yield();
+        }
+        if (ranJob) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]() { return stopping || queuedJobs.load(std::memory_order_relaxed) > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::run(TaskGraph& graph) {
+    const size_t taskCount = graph.tasks.size();
+    if (taskCount == 0) return;
+
+    // 先检查有没有环，否则会一直等下去
+    std::vector<uint32_t> indegree(taskCount);
+    std::vector<TaskGraph::TaskId> ready;
+    for (size_t i = 0; i < taskCount; i++) {
+        indegree[i] = graph.tasks[i].dependencyCount;
+        if (indegree[i] == 0) ready.push_back(static_cast<TaskGraph::TaskId>(i));
+    }
+    std::vector<TaskGraph::TaskId> roots = ready;
+    size_t visited = 0;
+    while (!ready.empty()) {
+        TaskGraph::TaskId id = ready.back();
+        ready.pop_back();
+        visited++;
+        for (TaskGraph::TaskId next : graph.tasks[id].successors) {
+            if (--indegree[next] == 0) ready.push_back(next);
+        }
+    }
+    if (visited != taskCount) {
+        throw std::runtime_error("task graph contains a cycle");
+    }
+
+    if (graph.remainingCapacity < taskCount) {
+        graph.remaining = std::make_unique<std::atomic<uint32_t>[]>(taskCount);
+        graph.remainingCapacity = taskCount;
+    }
+    for (size_t i = 0; i < taskCount; i++) {
+        graph.remaining[i].store(graph.tasks[i].dependencyCount, std::memory_order_relaxed);
+    }
+
+    // 任务完成后把依赖已满足的后继任务提交出去
+    Counter counter;
+    std::function<void(TaskGraph::TaskId)> launch = [&](TaskGraph::TaskId id) {
+        submit([&, id]() {
+            graph.tasks[id].fn();
+            for (TaskGraph::TaskId next : graph.tasks[id].successors) {
+                if (graph.remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    launch(next);
+                }
+            }
+        }, counter);
+    };
+    for (TaskGraph::TaskId id : roots) {
+        launch(id);
+    }
+    wait(counter);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+
+// Set of tasks with "runs after" edges, executed by JobSystem::run. The graph can be built once
+// and run every step; tasks without dependencies start immediately.
+class TaskGraph {
+public:
+    using TaskId = uint32_t;
+
+    TaskId addTask(std::function<void()> fn);
+    // `task` starts only after `dependsOn` has finished
+    void addDependency(TaskId task, TaskId dependsOn);
+    size_t size() const { return tasks.size(); }
+    void clear();
+
+private:
+    friend class JobSystem;
+
+    struct Task {
+        std::function<void()> fn;
+        std::vector<TaskId> successors;
+        uint32_t dependencyCount = 0;
+    };
+
+    std::vector<Task> tasks;
+    std::unique_ptr<std::atomic<uint32_t>[]> remaining; // unfinished dependencies while running
+    size_t remainingCapacity = 0;
+};
+
+// Work-stealing thread pool. Every thread owns a job deque: it pushes and pops its own jobs at the
+// back and, when it runs dry, steals from the front of the others. The thread that created the
+// system counts as thread 0 and executes jobs while it waits, so a system with one thread runs
+// everything inline.
+class JobSystem {
+public:
+    // Outstanding jobs of a batch; wait() returns once it drops to zero
+    class Counter {
+    public:
+        bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class JobSystem;
+        std::atomic<uint32_t> pending{0};
+    };
+
+    // threadCount includes the calling thread; 0 uses one thread per hardware core
+    explicit JobSystem(unsigned threadCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned getThreadCount() const { return threadCount; }
+    static unsigned getDefaultThreadCount();
+
+    void submit(std::function<void()> job, Counter& counter);
+    // Runs queued jobs on the calling thread until the counter is done
+    void wait(Counter& counter);
+
+    // Calls fn(begin, end) on chunks of at most grainSize items covering [0, count).
+    // Chunks are handed out dynamically; returns when all of them have finished.
+    template<typename Function>
+    void parallelFor(uint32_t count, uint32_t grainSize, Function&& fn);
+
+    // Runs every task of the graph, respecting dependencies. Throws on cycles.
+    void run(TaskGraph& graph);
+
+private:
+    struct Job {
+        std::function<void()> fn;
+        Counter* counter;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    unsigned threadCount;
+    std::vector<std::unique_ptr<WorkerQueue>> queues; // queues[0] is shared by non-worker threads
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<uint32_t> queuedJobs{0};
+    bool stopping = false;
+
+    unsigned currentQueue() const;
+    bool popJob(unsigned self, Job& job);
+    bool stealJob(unsigned self, Job& job);
+    bool runOneJob(unsigned self);
+    void workerMain(unsigned index);
+};
+
+template<typename Function>
+void JobSystem::parallelFor(uint32_t count, uint32_t grainSize, Function&& fn) {
+    if (count == 0) return;
+    grainSize = std::max(grainSize, 1u);
+    uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (threadCount == 1 || chunkCount == 1) {
+        fn(0u, count);
+        return;
+    }
+
+    // Each helper keeps grabbing the next chunk, so uneven chunks balance themselves
+    std::atomic<uint32_t> nextChunk{0};
+    auto runChunks = [&]() {
+        for (;;) {
+            uint32_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+            if (chunk >= chunkCount) break;
+            uint32_t begin = chunk * grainSize;
+            fn(begin, std::min(count, begin + grainSize));
+        }
+    };
+
+    Counter counter;
+    uint32_t helpers = std::min<uint32_t>(threadCount, chunkCount) - 1;
+    for (uint32_t i = 0; i < helpers; i++) {
+        submit([&runChunks]() { runChunks(); }, counter);
+    }
+    runChunks();
+    wait(counter);
+}
@@ -0,0 +1,306 @@
+#include "Narrowphase.h"
+#include <cfloat>
+#include <utility>
+
+namespace {
+
+// 两个形状的面分离程度差不多时优先用第一个形状的面，参考面不会来回切换
+constexpr float featureTolerance = 0.00005f;
+// 被侧面裁掉的点的特征编号，低位是侧面
+constexpr uint32_t clippedFeature = 0x8000u;
+// 核心距离小于这个值时法线不可靠，改用 EPA
+constexpr float minCoreDistance = 1.0e-5f;
+
+// 形状 B 的凸包在 A 各个面法线上的最大分离；offset 是 B 的位置减去 A 的位置
+float findMaxSeparation(const Shape& shapeA, const Shape& shapeB, const glm::vec2& offset, uint32_t& bestFace,
+                        uint32_t& bestVertex) {
+    const std::vector<glm::vec2>& hullA = shapeA.getHull();
+    const std::vector<glm::vec2>& normalsA = shapeA.getHullNormals();
+    const std::vector<glm::vec2>& hullB = shapeB.getHull();
+
+    float best = -FLT_MAX;
+    for (uint32_t i = 0; i < hullA.size(); i++) {
+        const glm::vec2& normal = normalsA[i];
+        uint32_t deepest = 0;
+        float deepestProjection = glm::dot(normal, hullB[0]);
+        for (uint32_t j = 1; j < hullB.size(); j++) {
+            float projection = glm::dot(normal, hullB[j]);
+            if (projection < deepestProjection) {
+                deepestProjection = projection;
+                deepest = j;
+            }
+        }
+        float separation = glm::dot(normal, hullB[deepest] + offset - hullA[i]);
+        if (separation > best) {
+            best = separation;
+            bestFace = i;
+            bestVertex = deepest;
+        }
+    }
+    return best;
+}
+
+struct ClipVertex {
+    glm::vec2 position;
+    uint32_t id;
+};
+
+// 保留线段在 dot(normal, p) <= offset 一侧的部分，返回剩下的点数
+int clipSegment(const ClipVertex in[2], ClipVertex out[2], const glm::vec2& normal, float offset, uint32_t clipId) {
+    int count = 0;
+    float distance0 = glm::dot(normal, in[0].position) - offset;
+    float distance1 = glm::dot(normal, in[1].position) - offset;
+    if (distance0 <= 0.0f) out[count++] = in[0];
+    if (distance1 <= 0.0f) out[count++] = in[1];
+    if (distance0 * distance1 < 0.0f) {
+        float t = distance0 / (distance0 - distance1);
+        out[count++] = {in[0].position + t * (in[1].position - in[0].position), clipId};
+    }
+    return count;
+}
+
+} // namespace
+
+bool computeBoundsManifold(const BodyStore& bodies, uint32_t a, uint32_t b, ContactManifold& out) {
+    const AABB& boundsA = bodies.bounds[a];
+    const AABB& boundsB = bodies.bounds[b];
+    if (!boundsA.overlaps(boundsB)) return false;
+
+    glm::vec2 overlapMin = glm::max(boundsA.min, boundsB.min);
+    glm::vec2 overlapMax = glm::min(boundsA.max, boundsB.max);
+    glm::vec2 overlap = overlapMax - overlapMin;
+    glm::vec2 delta = (boundsB.min + boundsB.max) - (boundsA.min + boundsA.max);
+
+    // 沿重叠最小的轴分开；特征编号记录轴和方向
+    uint32_t axis = overlap.x < overlap.y ? 0 : 1;
+    bool positive = delta[axis] >= 0.0f;
+    out.a = a;
+    out.b = b;
+    out.normal = glm::vec2(0.0f);
+    out.normal[axis] = positive ? 1.0f : -1.0f;
+    out.pointCount = 1;
+    out.points[0].position = (overlapMin + overlapMax) * 0.5f;
+    out.points[0].depth = overlap[axis];
+    out.points[0].featureId = axis * 2 + (positive ? 1 : 0);
+    return true;
+}
+
+float axisSeparation(const Shape& shapeA, const glm::vec2& positionA, const Shape& shapeB, const glm::vec2& positionB,
+                     const SeparatingAxis& axis) {
+    // 物体不旋转，面法线和最深的顶点都不变，只有位置差会变
+    if (axis.owner == 0) {
+        return glm::dot(shapeA.getHullNormals()[axis.face],
+                        shapeB.getHull()[axis.vertex] + (positionB - positionA) - shapeA.getHull()[axis.face]);
+    }
+    return glm::dot(shapeB.getHullNormals()[axis.face],
+                    shapeA.getHull()[axis.vertex] + (positionA - positionB) - shapeB.getHull()[axis.face]);
+}
+
+bool collidePolygons(const Shape& shapeA, const glm::vec2& positionA, const Shape& shapeB, const glm::vec2& positionB,
+                     ContactManifold& out, SeparatingAxis& axis) {
+    // 两组面法线都试一遍，任何一个轴上分离就没有接触
+    SeparatingAxis axisA = {0, 0, 0};
+    float separationA = findMaxSeparation(shapeA, shapeB, positionB - positionA, axisA.face, axisA.vertex);
+    if (separationA > 0.0f) {
+        axis = axisA;
+        return false;
+    }
+    SeparatingAxis axisB = {1, 0, 0};
+    float separationB = findMaxSeparation(shapeB, shapeA, positionA - positionB, axisB.face, axisB.vertex);
+    if (separationB > 0.0f) {
+        axis = axisB;
+        return false;
+    }
+
+    // 分离最大（穿透最浅）的面做参考面，另一个形状上和它最相对的边做入射边
+    bool flip = separationB > separationA + featureTolerance;
+    axis = flip ? axisB : axisA;
+    const Shape& reference = flip ? shapeB : shapeA;
+    const Shape& incident = flip ? shapeA : shapeB;
+    const glm::vec2& referencePosition = flip ? positionB : positionA;
+    const glm::vec2& incidentPosition = flip ? positionA : positionB;
+
+    const std::vector<glm::vec2>& referenceHull = reference.getHull();
+    const glm::vec2 normal = reference.getHullNormals()[axis.face];
+    const glm::vec2 v1 = referencePosition + referenceHull[axis.face];
+    const glm::vec2 v2 = referencePosition + referenceHull[(axis.face + 1) % referenceHull.size()];
+
+    const std::vector<glm::vec2>& incidentHull = incident.getHull();
+    const std::vector<glm::vec2>& incidentNormals = incident.getHullNormals();
+    uint32_t incidentFace = 0;
+    float minDot = FLT_MAX;
+    for (uint32_t i = 0; i < incidentNormals.size(); i++) {
+        float d = glm::dot(normal, incidentNormals[i]);
+        if (d < minDot) {
+            minDot = d;
+            incidentFace = i;
+        }
+    }
+    uint32_t incidentNext = (incidentFace + 1) % static_cast<uint32_t>(incidentHull.size());
+    ClipVertex incidentEdge[2] = {{incidentPosition + incidentHull[incidentFace], incidentFace},
+                                  {incidentPosition + incidentHull[incidentNext], incidentNext}};
+
+    // 用参考面两端的侧面裁剪入射边
+    glm::vec2 tangent = glm::normalize(v2 - v1);
+    ClipVertex clipped1[2];
+    ClipVertex clipped2[2];
+    if (clipSegment(incidentEdge, clipped1, -tangent, -glm::dot(tangent, v1), clippedFeature) < 2) return false;
+    if (clipSegment(clipped1, clipped2, tangent, glm::dot(tangent, v2), clippedFeature | 1) < 2) return false;
+
+    // 留下在参考面下方的点，位置取入射点和它在参考面上投影的中点
+    out.normal = flip ? -normal : normal;
+    out.pointCount = 0;
+    uint32_t featureBase = (flip ? 0x80000000u : 0u) | (axis.face << 16);
+    for (const ClipVertex& vertex : clipped2) {
+        float separation = glm::dot(normal, vertex.position - v1);
+        if (separation > 0.0f) continue;
+        ContactPoint& point = out.points[out.pointCount++];
+        point.position = vertex.position - normal * (separation * 0.5f);
+        point.depth = -separation;
+        point.featureId = featureBase | vertex.id;
+    }
+    return out.pointCount > 0;
+}
+
+bool collideConvex(const Shape& shapeA, const glm::vec2& positionA, const Shape& shapeB, const glm::vec2& positionB,
+                   ContactManifold& out, SimplexCache& simplex, uint32_t* iterations) {
+    ConvexProxy proxyA = ConvexProxy::fromShape(shapeA, positionA);
+    ConvexProxy proxyB = ConvexProxy::fromShape(shapeB, positionB);
+    DistanceResult distance = gjkDistance(proxyA, proxyB, simplex);
+    if (iterations) *iterations = distance.iterations;
+
+    const float radii = proxyA.radius + proxyB.radius;
+    if (distance.distance > radii) return false;
+
+    // 核心分开时法线沿两个最近点；核心重叠时由 EPA 求最浅的穿出方向
+    glm::vec2 normal;
+    float depth;
+    glm::vec2 pointA = distance.pointA;
+    glm::vec2 pointB = distance.pointB;
+    PenetrationResult penetration;
+    if (distance.distance > minCoreDistance) {
+        normal = (pointB - pointA) / distance.distance;
+        depth = radii - distance.distance;
+    } else if (epaPenetration(proxyA, proxyB, simplex, penetration)) {
+        normal = penetration.normal;
+        depth = radii + penetration.depth;
+        pointA = penetration.pointA;
+        pointB = penetration.pointB;
+    } else {
+        // 核心只是接触：沿两个中心的连线分开
+        glm::vec2 delta = positionB - positionA;
+        float length = glm::length(delta);
+        normal = length > minCoreDistance ? delta / length : glm::vec2(0.0f, 1.0f);
+        depth = radii;
+    }
+
+    // 两个外表面中间的点
+    out.normal = normal;
+    out.pointCount = 1;
+    out.points[0].position = (pointA + pointB) * 0.5f + normal * ((proxyA.radius - proxyB.radius) * 0.5f);
+    out.points[0].depth = depth;
+    out.points[0].featureId = 0;
+    return true;
+}
+
+bool Narrowphase::collide(const BodyStore& bodies, const std::vector<uint64_t>& bodyIds, uint32_t a, uint32_t b,
+                          ContactManifold& out, PairCache& pairCache) const {
+    pairCache.first = invalidId;
+    pairCache.earlyOut = false;
+    if (!bodies.bounds[a].overlaps(bodies.bounds[b])) return false;
+
+    // 按 id 排先后，缓存的轴、单纯形和特征编号与行的顺序无关
+    const Shape& shapeA = *bodies.shapes[a];
+    const Shape& shapeB = *bodies.shapes[b];
+    bool swapped = bodyIds[b] < bodyIds[a];
+    uint32_t first = swapped ? b : a;
+    uint32_t second = swapped ? a : b;
+    const Shape& shapeFirst = swapped ? shapeB : shapeA;
+    const Shape& shapeSecond = swapped ? shapeA : shapeB;
+
+    bool touching;
+    if (shapeA.getHull().empty() || shapeB.getHull().empty()) {
+        touching = computeBoundsManifold(bodies, first, second, out);
+    } else {
+        pairCache.first = bodyIds[first];
+        pairCache.second = bodyIds[second];
+        pairCache.axis = {0, 0, 0};
+        pairCache.simplex.count = 0;
+        const PairCache* cached = cache.find(pairCache.first, pairCache.second);
+
+        if (shapeA.isRounded() || shapeB.isRounded()) {
+            if (cached) pairCache.simplex = cached->simplex;
+            touching = collideConvex(shapeFirst, bodies.positions[first], shapeSecond, bodies.positions[second], out,
+                                     pairCache.simplex);
+        } else {
+            // 上一步的轴还能分开这一对就直接返回
+            if (cached && axisSeparation(shapeFirst, bodies.positions[first], shapeSecond, bodies.positions[second],
+                                         cached->axis) > 0.0f) {
+                pairCache.axis = cached->axis;
+                pairCache.earlyOut = true;
+                return false;
+            }
+            touching = collidePolygons(shapeFirst, bodies.positions[first], shapeSecond, bodies.positions[second], out,
+                                       pairCache.axis);
+        }
+    }
+    if (!touching) return false;
+    out.a = a;
+    out.b = b;
+    if (swapped) out.normal = -out.normal;
+    return true;
+}
+
+void Narrowphase::storePairs(const std::vector<PairCache>& pairCaches) {
+    nextCache.clear(pairCaches.size());
+    earlyOuts = 0;
+    for (const PairCache& pairCache : pairCaches) {
+        if (pairCache.first == invalidId) continue;
+        nextCache.insert(pairCache);
+        if (pairCache.earlyOut) earlyOuts++;
+    }
+    std::swap(cache, nextCache);
+}
+
+void Narrowphase::reset() {
+    cache.clear(0);
+    earlyOuts = 0;
+}
+
+size_t Narrowphase::PairTable::hash(uint64_t first, uint64_t second) {
+    uint64_t h = first * 0x9E3779B97F4A7C15ull ^ second;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 32;
+    return static_cast<size_t>(h);
+}
+
+void Narrowphase::PairTable::clear(size_t expected) {
+    size_t capacity = 16;
+    while (capacity < expected * 2) capacity *= 2;
+    PairCache empty = {};
+    empty.first = invalidId;
+    entries.assign(capacity, empty);
+    count = 0;
+}
+
+const Narrowphase::PairCache* Narrowphase::PairTable::find(uint64_t first, uint64_t second) const {
+    if (entries.empty()) return nullptr;
+    const size_t mask = entries.size() - 1;
+    for (size_t i = hash(first, second) & mask;; i = (i + 1) & mask) {
+        const PairCache& entry = entries[i];
+        if (entry.first == first && entry.second == second) return &entry;
+        if (entry.first == invalidId) return nullptr;
+    }
+}
+
+void Narrowphase::PairTable::insert(const PairCache& pairCache) {
+    // clear() 保证至少一半是空位，探测一定会停下
+    const size_t mask = entries.size() - 1;
+    size_t i = hash(pairCache.first, pairCache.second) & mask;
+    while (entries[i].first != invalidId && !(entries[i].first == pairCache.first && entries[i].second == pairCache.second)) {
+        i = (i + 1) & mask;
+    }
+    if (entries[i].first == invalidId) count++;
+    entries[i] = pairCache;
+}
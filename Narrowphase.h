@@ -0,0 +1,102 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "BodyStore.h"
+#include "Gjk.h"
+
+// One point of a contact manifold
+struct ContactPoint {
+    glm::vec2 position;   // world space
+    float depth;          // penetration along the normal, > 0 while overlapping
+    uint32_t featureId;   // touching features; the same id next step means the same contact
+};
+
+// Contact between bodies a and b (rows of a BodyStore); the normal points from a to b
+struct ContactManifold {
+    uint32_t a;
+    uint32_t b;
+    glm::vec2 normal;
+    uint32_t pointCount;
+    ContactPoint points[2];
+};
+
+// Manifold of two overlapping bounding boxes: the normal is the axis of least overlap, the
+// point is the centre of the overlap region. Returns false if the boxes do not overlap.
+bool computeBoundsManifold(const BodyStore& bodies, uint32_t a, uint32_t b, ContactManifold& out);
+
+// Axis found by the separating axis test: the normal of face `face` of one hull and the vertex
+// of the other hull that reaches furthest against it. Bodies do not rotate, so the vertex stays
+// the deepest one for as long as the pair exists and the separation along the axis is O(1).
+struct SeparatingAxis {
+    uint32_t owner;    // 0: face of the first shape, 1: face of the second
+    uint32_t face;
+    uint32_t vertex;
+};
+
+// Separating axis test between the convex hulls of two shapes placed at the given positions.
+// Always writes the axis of largest separation. If no axis separates the hulls, fills `out`
+// with the normal (from the first shape to the second), the depth and up to two contact points
+// clipped from the incident edge against the reference face, and returns true. Both shapes
+// must have a hull. out.a and out.b are left to the caller.
+bool collidePolygons(const Shape& shapeA, const glm::vec2& positionA, const Shape& shapeB, const glm::vec2& positionB,
+                     ContactManifold& out, SeparatingAxis& axis);
+// Signed distance between the hulls along a known axis; > 0 means the axis still separates them
+float axisSeparation(const Shape& shapeA, const glm::vec2& positionA, const Shape& shapeB, const glm::vec2& positionB,
+                     const SeparatingAxis& axis);
+
+// Contact between two convex shapes of any kind through GJK on their cores, and EPA if the
+// cores overlap. Gives one point, midway between the inflated surfaces. simplex is the pair's
+// simplex from the previous step (count 0 for none) and is updated in place. iterations, if
+// given, receives the number of GJK iterations.
+bool collideConvex(const Shape& shapeA, const glm::vec2& positionA, const Shape& shapeB, const glm::vec2& positionB,
+                   ContactManifold& out, SimplexCache& simplex, uint32_t* iterations = nullptr);
+
+// Narrowphase for the engine: pairs of plain polygons go through collidePolygons, pairs with a
+// rounded shape through collideConvex, bodies whose shape has no hull through
+// computeBoundsManifold. The separating axis and the GJK simplex of every pair are kept until
+// the next step; a polygon pair the cached axis still separates is rejected with one dot
+// product, and GJK starts from the cached simplex.
+class Narrowphase {
+public:
+    // Result of one pair, handed back to storePairs() after the step
+    struct PairCache {
+        uint64_t first;   // body ids, first < second; first == invalidId if nothing to keep
+        uint64_t second;
+        SeparatingAxis axis;
+        SimplexCache simplex;
+        bool earlyOut;    // rejected by the cached axis
+    };
+    static constexpr uint64_t invalidId = ~0ull;
+
+    // Tests rows a and b. bodyIds gives every row an id that survives row reordering and is never
+    // reused (the engine passes handle slot and generation); the pair cache is keyed by it. The manifold is for a and b, but its
+    // feature ids are computed with the lower id first, so they do not change when rows swap. Only reads the cache, so pairs can be
+    // tested in parallel.
+    bool collide(const BodyStore& bodies, const std::vector<uint64_t>& bodyIds, uint32_t a, uint32_t b,
+                 ContactManifold& out, PairCache& pairCache) const;
+    // Replaces the cache with the axes and simplices of this step's pairs
+    void storePairs(const std::vector<PairCache>& pairCaches);
+    // Drops the cache
+    void reset();
+
+    // Pairs kept from the last step, and the pairs of the last step the cached axis rejected
+    size_t getCachedPairCount() const { return cache.count; }
+    size_t getEarlyOutCount() const { return earlyOuts; }
+
+private:
+    // Open-addressing table keyed by the id pair, like the contact solver's impulse cache
+    struct PairTable {
+        std::vector<PairCache> entries;   // entry.first == invalidId while free
+        size_t count = 0;
+
+        void clear(size_t expected);
+        const PairCache* find(uint64_t first, uint64_t second) const;
+        void insert(const PairCache& pairCache);
+        static size_t hash(uint64_t first, uint64_t second);
+    };
+
+    PairTable cache;
+    PairTable nextCache;
+    size_t earlyOuts = 0;
+};
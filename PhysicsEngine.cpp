@@ -1,207 +1,600 @@
 #include "PhysicsEngine.h"
+#include "Profiler.h"
 #include <algorithm>
 #include <iostream>
+#include <cmath>
+#include <chrono>
+
+namespace {
+
+// 每个任务处理的物体数，太小时调度开销会超过计算本身
+constexpr uint32_t bodyGrainSize = 512;
+constexpr uint32_t pairGrainSize = 4096;
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
 
 // PhysicsObject 实现
 PhysicsObject::PhysicsObject(const std::vector<Vertex>& verts, float m) 
-    : vertices(verts), originalVertices(verts), mass(m), elasticity(0.8f), friction(0.1f), deformation(0.0f) {
-    updateBounds();
+    : store(nullptr), index(0), localStore(std::make_unique<BodyStore>()) {
+    store = localStore.get();
+    index = store->add(verts, m);
+}
+
+PhysicsObject::PhysicsObject(ShapeRef shape, float m)
+    : store(nullptr), index(0), localStore(std::make_unique<BodyStore>()) {
+    store = localStore.get();
+    index = store->add(std::move(shape), m);
 }
 
+PhysicsObject::PhysicsObject(PhysicsEngine& owner, BodyStore& engineStore, uint32_t row, BodyHandle bodyHandle)
+    : store(&engineStore), index(row), handle(bodyHandle), engine(&owner) {}
+
 PhysicsObject::~PhysicsObject() {}
 
+void PhysicsObject::attach(BodyStore& target) {
+    // 把状态搬进引擎的存储，之后只作为句柄使用
+    index = target.copyFrom(*store, index);
+    store = &target;
+    localStore.reset();
+}
+
+void PhysicsObject::detach() {
+    // 从引擎移除时把状态拷回自己的存储
+    localStore = std::make_unique<BodyStore>();
+    localStore->copyFrom(*store, index);
+    store = localStore.get();
+    index = 0;
+    handle = BodyHandle();
+    engine = nullptr;
+}
+
+void PhysicsObject::wake() {
+    // 叫醒可能会移动行，index 随之更新，所以要在改状态之前调用
+    if (engine) engine->wake(handle);
+}
+
 void PhysicsObject::setPosition(const glm::vec2& pos) {
-    position = pos;
-    updateBounds();
+    wake();
+    store->teleport(index, pos);
 }
 
 void PhysicsObject::setVelocity(const glm::vec2& vel) {
-    velocity = vel;
+    wake();
+    store->velocities[index] = vel;
 }
 
 void PhysicsObject::setMass(float m) {
-    mass = m;
+    wake();
+    store->setMass(index, m);
 }
 
 void PhysicsObject::setElasticity(float e) {
-    elasticity = std::clamp(e, 0.0f, 1.0f);
+    store->elasticities[index] = std::clamp(e, 0.0f, 1.0f);
 }
 
 void PhysicsObject::setFriction(float f) {
-    friction = std::clamp(f, 0.0f, 1.0f);
+    store->frictions[index] = std::clamp(f, 0.0f, 1.0f);
 }
 
 void PhysicsObject::applyForce(const glm::vec2& force) {
-    acceleration += force / mass;
+    wake();
+    store->accelerations[index] += force * store->inverseMasses[index];
 }
 
 void PhysicsObject::applyImpulse(const glm::vec2& impulse) {
-    velocity += impulse / mass;
+    wake();
+    store->velocities[index] += impulse * store->inverseMasses[index];
 }
 
 void PhysicsObject::update(float deltaTime) {
-    // 更新速度和位置
-    velocity += acceleration * deltaTime;
-    position += velocity * deltaTime;
-    
-    // 重置加速度
-    acceleration = glm::vec2(0.0f);
-    
-    // 更新顶点位置
-    for (size_t i = 0; i < vertices.size(); i++) {
-        vertices[i].position = originalVertices[i].position + position;
+    store->integrate(index, deltaTime);
+    store->updateGeometry(index);
+}
+
+bool PhysicsObject::checkCollision(const PhysicsObject& other) const {
+    return BodyStore::checkCollision(*store, index, *other.store, other.index);
+}
+
+void PhysicsObject::resolveCollision(PhysicsObject& other) {
+    BodyStore::resolveCollision(*store, index, *other.store, other.index);
+}
+
+void PhysicsObject::deform(const glm::vec2& impactPoint, float force) {
+    store->deform(index, impactPoint, force);
+}
+
+bool PhysicsObject::pointInTriangle(const glm::vec2& point, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) const {
+    float area = 0.5f * (-b.y * c.x + a.y * (-b.x + c.x) + a.x * (b.y - c.y) + b.x * c.y);
+    float s = 1.0f / (2.0f * area) * (a.y * c.x - a.x * c.y + (c.y - a.y) * point.x + (a.x - c.x) * point.y);
+    float t = 1.0f / (2.0f * area) * (a.x * b.y - a.y * b.x + (a.y - b.y) * point.x + (b.x - a.x) * point.y);
+    return s >= 0 && t >= 0 && (s + t) <= 1;
+}
+
+// PhysicsEngine 实现
+PhysicsEngine::PhysicsEngine() 
+    : gravity(0.0f, -9.8f), groundLevel(-0.8f), airResistance(0.02f), simdLevel(detectSimdLevel()),
+      fixedTimeStep(1.0f / 60.0f), maxSubSteps(5), accumulator(0.0),
+      jobs(std::make_unique<JobSystem>()), broadphase(createBroadphase(BroadphaseType::SpatialHash)),
+      stepDeltaTime(1.0f / 60.0f), sleepVelocity(0.05f), timeToSleep(0.5f) {
+    broadphase->setJobSystem(jobs.get());
+    contactSolver.setJobSystem(jobs.get());
+    contactSolver.setSimdLevel(simdLevel);
+    buildStepGraph();
+}
+
+PhysicsEngine::~PhysicsEngine() {
+    // 引擎销毁后外部持有的对象仍然可用
+    for (auto& obj : objects) {
+        if (obj) obj->detach();
     }
-    
-    updateBounds();
 }
 
-void PhysicsObject::updateBounds() {
-    if (vertices.empty()) return;
+BodyHandle PhysicsEngine::allocateSlot(uint32_t dense) {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.push_back({BodyHandle::invalidIndex, 0, BodyHandle::invalidIndex});
+    }
+    slots[slot].dense = dense;
+    denseToSlot.push_back(slot);
+    bodyKeys.push_back(static_cast<uint64_t>(slots[slot].generation) << 32 | slot);
+    return {slot, slots[slot].generation};
+}
+
+BodyHandle PhysicsEngine::addObject(std::shared_ptr<PhysicsObject> obj) {
+    if (!obj) return BodyHandle();
+    if (obj->store == &bodies) return obj->handle;
     
-    minBounds = maxBounds = vertices[0].position;
-    for (const auto& vertex : vertices) {
-        minBounds.x = std::min(minBounds.x, vertex.position.x);
-        minBounds.y = std::min(minBounds.y, vertex.position.y);
-        maxBounds.x = std::max(maxBounds.x, vertex.position.x);
-        maxBounds.y = std::max(maxBounds.y, vertex.position.y);
+    obj->attach(bodies);
+    obj->handle = allocateSlot(obj->index);
+    obj->engine = this;
+    objects.push_back(obj);
+    broadphase->createProxy(obj->handle.index, bodies.bounds[obj->index], true);
+    insertAwake(obj->index);
+    bodyListVersion++;
+    return obj->handle;
+}
+
+void PhysicsEngine::addObjects(const std::shared_ptr<PhysicsObject>* objs, size_t count, BodyHandle* outHandles) {
+    for (size_t i = 0; i < count; i++) {
+        BodyHandle handle = addObject(objs[i]);
+        if (outHandles) outHandles[i] = handle;
     }
 }
 
-bool PhysicsObject::checkCollision(const PhysicsObject& other) const {
-    // 简单的AABB碰撞检测
-    return !(maxBounds.x < other.minBounds.x || minBounds.x > other.maxBounds.x ||
-             maxBounds.y < other.minBounds.y || minBounds.y > other.maxBounds.y);
+void PhysicsEngine::addBodies(const BodyDesc* descs, size_t count, BodyHandle* outHandles) {
+    // 直接写入存储，不创建 PhysicsObject
+    for (size_t i = 0; i < count; i++) {
+        const BodyDesc& desc = descs[i];
+        uint32_t dense = desc.shape ? bodies.add(desc.shape, desc.mass) : bodies.add(desc.vertices, desc.mass);
+        bodies.positions[dense] = desc.position;
+        bodies.previousPositions[dense] = desc.position;
+        bodies.velocities[dense] = desc.velocity;
+        bodies.elasticities[dense] = std::clamp(desc.elasticity, 0.0f, 1.0f);
+        bodies.frictions[dense] = std::clamp(desc.friction, 0.0f, 1.0f);
+        bodies.updateGeometry(dense);
+        
+        objects.push_back(nullptr);
+        BodyHandle handle = allocateSlot(dense);
+        broadphase->createProxy(handle.index, bodies.bounds[dense], true);
+        insertAwake(dense);
+        if (outHandles) outHandles[i] = handle;
+    }
+    if (count > 0) bodyListVersion++;
 }
 
-void PhysicsObject::resolveCollision(PhysicsObject& other) {
-    // 计算碰撞响应
-    glm::vec2 normal = glm::normalize(position - other.position);
-    float relativeVelocity = glm::dot(velocity - other.velocity, normal);
+void PhysicsEngine::insertAwake(uint32_t dense) {
+    // 新物体追加在最后一行，换到睡眠区前面
+    swapRows(dense, awakeCount);
+    awakeCount++;
+}
+
+void PhysicsEngine::swapRows(uint32_t i, uint32_t j) {
+    if (i == j) return;
+    bodies.swapRows(i, j);
+    std::swap(objects[i], objects[j]);
+    if (objects[i]) objects[i]->index = i;
+    if (objects[j]) objects[j]->index = j;
+    std::swap(denseToSlot[i], denseToSlot[j]);
+    std::swap(bodyKeys[i], bodyKeys[j]);
+    slots[denseToSlot[i]].dense = i;
+    slots[denseToSlot[j]].dense = j;
+}
+
+void PhysicsEngine::removeBodyAt(uint32_t dense) {
+    uint32_t slot = denseToSlot[dense];
     
-    if (relativeVelocity > 0) return; // 物体正在分离
+    // 睡着的岛少了一个物体，剩下的可能不再稳定，整个岛叫醒
+    if (slots[slot].island != BodyHandle::invalidIndex) {
+        wakeIsland(slots[slot].island);
+        dense = slots[slot].dense;
+    }
     
-    float restitution = (elasticity + other.elasticity) * 0.5f;
-    float impulse = -(1.0f + restitution) * relativeVelocity;
-    impulse /= 1.0f/mass + 1.0f/other.mass;
+    if (objects[dense]) {
+        objects[dense]->detach();
+        objects[dense].reset();
+    }
     
-    glm::vec2 impulseVector = impulse * normal;
+    // 先换到醒着区的末尾，再换到最后一行删掉，两个区都保持连续
+    uint32_t last = static_cast<uint32_t>(bodies.size()) - 1;
+    swapRows(dense, awakeCount - 1);
+    swapRows(awakeCount - 1, last);
+    awakeCount--;
+    bodies.swapRemove(last);
+    objects.pop_back();
+    denseToSlot.pop_back();
+    bodyKeys.pop_back();
+    broadphase->destroyProxy(slot);
     
-    applyImpulse(impulseVector);
-    other.applyImpulse(-impulseVector);
+    // 释放槽位，代数加一让旧句柄和缓存里旧的键失效
+    slots[slot].dense = BodyHandle::invalidIndex;
+    slots[slot].generation++;
+    freeSlots.push_back(slot);
     
-    // 分离物体以防止重叠
-    float overlap = 0.1f;
-    glm::vec2 separation = normal * overlap;
-    position += separation;
-    other.position -= separation;
+    bodyListVersion++;
 }
 
-void PhysicsObject::deform(const glm::vec2& impactPoint, float force) {
-    // 简单的变形效果：根据冲击力调整顶点位置
-    deformation += force * 0.01f;
-    deformation = std::min(deformation, 0.3f); // 限制最大变形
-    
-    for (size_t i = 0; i < vertices.size(); i++) {
-        glm::vec2 toImpact = impactPoint - vertices[i].position;
-        float distance = glm::length(toImpact);
-        if (distance > 0.001f) {
-            float deformationFactor = deformation / (1.0f + distance);
-            vertices[i].position += glm::normalize(toImpact) * deformationFactor * 0.1f;
-        }
+void PhysicsEngine::removeObject(std::shared_ptr<PhysicsObject> obj) {
+    if (!obj || obj->store != &bodies) return;
+    removeBodyAt(obj->index);
+}
+
+bool PhysicsEngine::removeObject(BodyHandle handle) {
+    uint32_t dense = getBodyIndex(handle);
+    if (dense == BodyHandle::invalidIndex) return false;
+    removeBodyAt(dense);
+    return true;
+}
+
+void PhysicsEngine::removeObjects(const BodyHandle* handles, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        removeObject(handles[i]);
     }
 }
 
-void PhysicsObject::updateVertexBuffer(VkDevice device, VkDeviceMemory vertexBufferMemory) {
-    // 更新GPU内存中的顶点数据
-    void* data;
-    vkMapMemory(device, vertexBufferMemory, 0, vertices.size() * sizeof(Vertex), 0, &data);
-    memcpy(data, vertices.data(), vertices.size() * sizeof(Vertex));
-    vkUnmapMemory(device, vertexBufferMemory);
+bool PhysicsEngine::isValid(BodyHandle handle) const {
+    return handle.index < slots.size() &&
+           slots[handle.index].generation == handle.generation &&
+           slots[handle.index].dense != BodyHandle::invalidIndex;
 }
 
-void PhysicsObject::draw(VkCommandBuffer commandBuffer, VkBuffer vertexBuffer) {
-    VkBuffer vertexBuffers[] = {vertexBuffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdDraw(commandBuffer, static_cast<uint32_t>(vertices.size()), 1, 0, 0);
+uint32_t PhysicsEngine::getBodyIndex(BodyHandle handle) const {
+    return isValid(handle) ? slots[handle.index].dense : BodyHandle::invalidIndex;
 }
 
-bool PhysicsObject::pointInTriangle(const glm::vec2& point, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) const {
-    float area = 0.5f * (-b.y * c.x + a.y * (-b.x + c.x) + a.x * (b.y - c.y) + b.x * c.y);
-    float s = 1.0f / (2.0f * area) * (a.y * c.x - a.x * c.y + (c.y - a.y) * point.x + (a.x - c.x) * point.y);
-    float t = 1.0f / (2.0f * area) * (a.x * b.y - a.y * b.x + (a.y - b.y) * point.x + (b.x - a.x) * point.y);
-    return s >= 0 && t >= 0 && (s + t) <= 1;
+std::shared_ptr<PhysicsObject> PhysicsEngine::getObject(BodyHandle handle) {
+    uint32_t dense = getBodyIndex(handle);
+    if (dense == BodyHandle::invalidIndex) return nullptr;
+    
+    if (!objects[dense]) {
+        objects[dense] = std::shared_ptr<PhysicsObject>(new PhysicsObject(*this, bodies, dense, handle));
+    }
+    return objects[dense];
 }
 
-// PhysicsEngine 实现
-PhysicsEngine::PhysicsEngine() : gravity(0.0f, -9.8f), groundLevel(-0.8f), airResistance(0.02f) {}
+bool PhysicsEngine::isSleeping(BodyHandle handle) const {
+    return isValid(handle) && slots[handle.index].island != BodyHandle::invalidIndex;
+}
+
+bool PhysicsEngine::wake(BodyHandle handle) {
+    if (!isValid(handle)) return false;
+    if (slots[handle.index].island != BodyHandle::invalidIndex) {
+        wakeIsland(slots[handle.index].island);
+    }
+    // 重新计时，刚被叫醒的物体不会在这一步又睡着
+    bodies.sleepTimes[slots[handle.index].dense] = 0.0f;
+    return true;
+}
 
-PhysicsEngine::~PhysicsEngine() {}
+void PhysicsEngine::wakeAll() {
+    for (uint32_t island = 0; island < sleepingIslands.size(); island++) {
+        if (!sleepingIslands[island].empty()) wakeIsland(island);
+    }
+}
 
-void PhysicsEngine::addObject(std::shared_ptr<PhysicsObject> obj) {
-    objects.push_back(obj);
+void PhysicsEngine::wakeIsland(uint32_t island) {
+    // 岛里的物体按入睡时的顺序换回醒着区的末尾
+    for (uint32_t slot : sleepingIslands[island]) {
+        slots[slot].island = BodyHandle::invalidIndex;
+        uint32_t dense = slots[slot].dense;
+        bodies.sleepTimes[dense] = 0.0f;
+        broadphase->setProxyMoving(slot, true, bodies.bounds[dense]);
+        swapRows(dense, awakeCount);
+        awakeCount++;
+    }
+    sleepingIslands[island].clear();
+    freeIslands.push_back(island);
+    bodyListVersion++;
 }
 
-void PhysicsEngine::removeObject(std::shared_ptr<PhysicsObject> obj) {
-    objects.erase(std::remove(objects.begin(), objects.end(), obj), objects.end());
+void PhysicsEngine::setSleepingEnabled(bool enabled) {
+    sleepingEnabled = enabled;
+    if (!enabled) wakeAll();
+}
+
+void PhysicsEngine::setGravity(const glm::vec2& g) {
+    gravity = g;
+    wakeAll();
+}
+
+void PhysicsEngine::setGroundLevel(float level) {
+    groundLevel = level;
+    wakeAll();
+}
+
+void PhysicsEngine::setBroadphase(BroadphaseType type) {
+    setBroadphase(createBroadphase(type));
+}
+
+void PhysicsEngine::setBroadphase(std::unique_ptr<Broadphase> newBroadphase) {
+    if (!newBroadphase) return;
+    broadphase = std::move(newBroadphase);
+    broadphase->setJobSystem(jobs.get());
+    
+    // 新的 broadphase 是空的，按槽位登记所有物体，睡着的作为静态代理
+    broadphase->reset();
+    for (uint32_t row = 0; row < bodies.size(); row++) {
+        broadphase->createProxy(denseToSlot[row], bodies.bounds[row], row < awakeCount);
+    }
+}
+
+void PhysicsEngine::setSimdLevel(SimdLevel level) {
+    simdLevel = std::min(level, detectSimdLevel());
+    contactSolver.setSimdLevel(simdLevel);
+}
+
+void PhysicsEngine::setThreadCount(unsigned count) {
+    jobs = std::make_unique<JobSystem>(count);
+    broadphase->setJobSystem(jobs.get());
+    contactSolver.setJobSystem(jobs.get());
 }
 
 void PhysicsEngine::update(float deltaTime) {
-    for (auto& obj : objects) {
-        // 应用重力
-        obj->applyForce(gravity * obj->getMass());
-        
-        // 应用空气阻力
-        applyAirResistance(obj);
-        
-        // 更新物理对象
-        obj->update(deltaTime);
-        
-        // 检查地面碰撞
-        applyGroundCollision(obj);
+    PROFILE_ZONE("PhysicsEngine::update");
+    stepDeltaTime = deltaTime;
+    
+    // 各阶段按依赖跑在任务图上，阶段内部再用 parallelFor 分块
+    jobs->run(stepGraph);
+}
+
+void PhysicsEngine::buildStepGraph() {
+    // 积分 -> 粗检测 -> 细检测 -> 响应
+    TaskGraph::TaskId integrate = stepGraph.addTask([this]() { integrateStep(); });
+    TaskGraph::TaskId broadphaseTask = stepGraph.addTask([this]() { runBroadphase(); });
+    TaskGraph::TaskId narrowphaseTask = stepGraph.addTask([this]() { runNarrowphase(); });
+    TaskGraph::TaskId response = stepGraph.addTask([this]() { respond(); });
+    stepGraph.addDependency(broadphaseTask, integrate);
+    stepGraph.addDependency(narrowphaseTask, broadphaseTask);
+    stepGraph.addDependency(response, narrowphaseTask);
+}
+
+void PhysicsEngine::integrateStep() {
+    auto start = Clock::now();
+    const IntegratorParams params = {gravity, airResistance, groundLevel, stepDeltaTime, ContactSolver::restitutionThreshold};
+    
+    // 逐物体的步骤互不依赖，按块分给各线程，块内依次执行
+    {
+        PROFILE_ZONE("integrate");
+        // 只处理醒着的行，睡着的物体不花时间
+        jobs->parallelFor(awakeCount, bodyGrainSize, [&](uint32_t begin, uint32_t end) {
+            // 保存上一步的位置，渲染时插值用
+            std::copy(bodies.positions.begin() + begin, bodies.positions.begin() + end, bodies.previousPositions.begin() + begin);
+            
+            // 重力、空气阻力、积分和地面碰撞
+            integrateBodies(bodies, begin, end, params, simdLevel);
+            
+            // 更新顶点和包围盒
+            updateGeometry(begin, end);
+        });
     }
+    lastStepTimings.integrate = elapsedMs(start, Clock::now());
+}
+
+int PhysicsEngine::advance(float frameTime) {
+    accumulator += std::max(frameTime, 0.0f);
     
-    // 检查对象间的碰撞
-    checkCollisions();
+    int steps = 0;
+    while (accumulator >= fixedTimeStep && steps < maxSubSteps) {
+        update(fixedTimeStep);
+        accumulator -= fixedTimeStep;
+        steps++;
+    }
+    
+    // 达到上限后丢掉多余的整步，避免越追越慢
+    if (accumulator >= fixedTimeStep) {
+        accumulator = std::fmod(accumulator, static_cast<double>(fixedTimeStep));
+    }
+    return steps;
+}
+
+void PhysicsEngine::updateGeometry(uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; i++) {
+        bodies.updateGeometry(i);
+    }
 }
 
 void PhysicsEngine::checkCollisions() {
-    for (size_t i = 0; i < objects.size(); i++) {
-        for (size_t j = i + 1; j < objects.size(); j++) {
-            if (objects[i]->checkCollision(*objects[j])) {
-                objects[i]->resolveCollision(*objects[j]);
-                
-                // 应用变形效果
-                glm::vec2 impactPoint = (objects[i]->getPosition() + objects[j]->getPosition()) * 0.5f;
-                float impactForce = glm::length(objects[i]->getVelocity() - objects[j]->getVelocity());
-                objects[i]->deform(impactPoint, impactForce);
-                objects[j]->deform(impactPoint, impactForce);
-            }
+    runBroadphase();
+    runNarrowphase();
+    respond();
+}
+
+void PhysicsEngine::runBroadphase() {
+    // 粗检测：broadphase 直接读取包围盒数组
+    auto start = Clock::now();
+    {
+        PROFILE_ZONE("broadphase");
+        // 醒着的行是移动代理，代理编号是槽位；全部睡着时没有新的接触
+        if (awakeCount > 0) {
+            broadphase->updatePairs(bodies.bounds, denseToSlot, awakeCount, candidatePairs);
+        } else {
+            candidatePairs.clear();
         }
+        // 按槽位排好的对换成行号
+        for (BroadphasePair& pair : candidatePairs) {
+            pair = {slots[pair.a].dense, slots[pair.b].dense};
+        }
+    }
+    lastStepTimings.broadphase = elapsedMs(start, Clock::now());
+}
+
+void PhysicsEngine::runNarrowphase() {
+    // 细检测只读物体和上一步的分离轴、单纯形，可以并行；求解会改动两个物体，按对的顺序串行处理以保证结果确定
+    auto start = Clock::now();
+    const uint32_t pairCount = static_cast<uint32_t>(candidatePairs.size());
+    pairContacts.resize(pairCount);
+    pairManifolds.resize(pairCount);
+    pairCaches.resize(pairCount);
+    {
+        PROFILE_ZONE("narrowphase");
+        jobs->parallelFor(pairCount, pairGrainSize, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t p = begin; p < end; p++) {
+                const BroadphasePair& pair = candidatePairs[p];
+                pairContacts[p] = narrowphase.collide(bodies, bodyKeys, pair.a, pair.b, pairManifolds[p], pairCaches[p]);
+            }
+        });
+        narrowphase.storePairs(pairCaches);
     }
+    lastStepTimings.narrowphase = elapsedMs(start, Clock::now());
 }
 
-void PhysicsEngine::applyGroundCollision(std::shared_ptr<PhysicsObject> obj) {
-    // 检查是否与地面碰撞
-    if (obj->getPosition().y < groundLevel) {
-        obj->setPosition(glm::vec2(obj->getPosition().x, groundLevel));
+void PhysicsEngine::respond() {
+    auto start = Clock::now();
+    {
+        PROFILE_ZONE("response");
+        contacts.clear();
+        for (size_t p = 0; p < pairContacts.size(); p++) {
+            if (pairContacts[p]) contacts.push_back(pairManifolds[p]);
+        }
+        wakeTouchedIslands();
+        contactSolver.solve(bodies, bodyKeys, contacts, stepDeltaTime, groundLevel);
         
-        // 应用反弹和摩擦力
-        glm::vec2 vel = obj->getVelocity();
-        vel.y = -vel.y * obj->getElasticity();
-        vel.x *= (1.0f - obj->getFriction());
-        obj->setVelocity(vel);
+        // 应用变形效果
+        for (const ContactManifold& contact : contacts) {
+            glm::vec2 impactPoint = contact.points[0].position;
+            float impactForce = glm::length(bodies.velocities[contact.a] - bodies.velocities[contact.b]);
+            bodies.deform(contact.a, impactPoint, impactForce);
+            bodies.deform(contact.b, impactPoint, impactForce);
+        }
+        
+        if (sleepingEnabled) updateSleeping(stepDeltaTime);
     }
+    lastStepTimings.response = elapsedMs(start, Clock::now());
 }
 
-void PhysicsEngine::applyAirResistance(std::shared_ptr<PhysicsObject> obj) {
-    glm::vec2 vel = obj->getVelocity();
-    glm::vec2 resistance = -vel * airResistance;
-    obj->applyForce(resistance);
+void PhysicsEngine::wakeTouchedIslands() {
+    // 醒着的动态物体碰到睡着的动态物体时，叫醒它所在的岛
+    const float* inverseMasses = bodies.inverseMasses.data();
+    auto sleepingDynamic = [&](uint32_t row) { return row >= awakeCount && inverseMasses[row] > 0.0f; };
+    auto awakeDynamic = [&](uint32_t row) { return row < awakeCount && inverseMasses[row] > 0.0f; };
+    
+    wokenIslands.clear();
+    for (const ContactManifold& contact : contacts) {
+        if (sleepingDynamic(contact.a) && awakeDynamic(contact.b)) {
+            wokenIslands.push_back(slots[denseToSlot[contact.a]].island);
+        } else if (sleepingDynamic(contact.b) && awakeDynamic(contact.a)) {
+            wokenIslands.push_back(slots[denseToSlot[contact.b]].island);
+        }
+    }
+    
+    if (!wokenIslands.empty()) {
+        // 叫醒会移动行：接触先换成槽位，叫醒后再换回行号
+        for (ContactManifold& contact : contacts) {
+            contact.a = denseToSlot[contact.a];
+            contact.b = denseToSlot[contact.b];
+        }
+        for (uint32_t island : wokenIslands) {
+            if (!sleepingIslands[island].empty()) wakeIsland(island);
+        }
+        for (ContactManifold& contact : contacts) {
+            contact.a = slots[contact.a].dense;
+            contact.b = slots[contact.b].dense;
+        }
+    }
+    
+    // 睡着的动态物体只被静态物体碰到时不参与求解，保持不动
+    contacts.erase(std::remove_if(contacts.begin(), contacts.end(), [&](const ContactManifold& contact) {
+        return sleepingDynamic(contact.a) || sleepingDynamic(contact.b);
+    }), contacts.end());
 }
 
-void PhysicsEngine::renderAll(VkCommandBuffer commandBuffer, VkBuffer vertexBuffer) {
-    for (auto& obj : objects) {
-        obj->draw(commandBuffer, vertexBuffer);
+void PhysicsEngine::updateSleeping(float deltaTime) {
+    // 速度低于阈值的持续时间
+    const float sleepVelocitySquared = sleepVelocity * sleepVelocity;
+    for (uint32_t i = 0; i < awakeCount; i++) {
+        const glm::vec2& v = bodies.velocities[i];
+        bodies.sleepTimes[i] = glm::dot(v, v) > sleepVelocitySquared ? 0.0f : bodies.sleepTimes[i] + deltaTime;
+    }
+    
+    // 并查集：接触把两个醒着的动态物体连成一个岛；静态物体不传递
+    islandParents.resize(awakeCount);
+    for (uint32_t i = 0; i < awakeCount; i++) islandParents[i] = i;
+    auto find = [&](uint32_t i) {
+        while (islandParents[i] != i) {
+            islandParents[i] = islandParents[islandParents[i]];
+            i = islandParents[i];
+        }
+        return i;
+    };
+    for (const ContactManifold& contact : contacts) {
+        if (contact.a >= awakeCount || contact.b >= awakeCount) continue;
+        if (bodies.inverseMasses[contact.a] <= 0.0f || bodies.inverseMasses[contact.b] <= 0.0f) continue;
+        uint32_t rootA = find(contact.a), rootB = find(contact.b);
+        // 小编号做根，结果和接触顺序以外的因素无关
+        if (rootA < rootB) islandParents[rootB] = rootA;
+        else if (rootB < rootA) islandParents[rootA] = rootB;
+    }
+    
+    // 岛里最短的计时决定整个岛能不能睡
+    islandSleepTimes.assign(awakeCount, timeToSleep);
+    for (uint32_t i = 0; i < awakeCount; i++) {
+        float& time = islandSleepTimes[find(i)];
+        time = std::min(time, bodies.sleepTimes[i]);
+    }
+    sleepingRows.clear();
+    for (uint32_t i = 0; i < awakeCount; i++) {
+        if (islandSleepTimes[find(i)] >= timeToSleep) sleepingRows.push_back(i);
+    }
+    if (sleepingRows.empty()) return;
+    
+    // 每个根分到一个睡眠岛，记下物体的槽位；根总是岛里最小的行，最先遇到
+    rootIslands.resize(awakeCount);
+    for (uint32_t row : sleepingRows) {
+        uint32_t root = find(row);
+        if (root == row) {
+            if (!freeIslands.empty()) {
+                rootIslands[root] = freeIslands.back();
+                freeIslands.pop_back();
+            } else {
+                rootIslands[root] = static_cast<uint32_t>(sleepingIslands.size());
+                sleepingIslands.emplace_back();
+            }
+        }
+        uint32_t island = rootIslands[root];
+        
+        uint32_t slot = denseToSlot[row];
+        sleepingIslands[island].push_back(slot);
+        slots[slot].island = island;
+        bodies.velocities[row] = glm::vec2(0.0f);
+        bodies.accelerations[row] = glm::vec2(0.0f);
+        bodies.previousPositions[row] = bodies.positions[row];
+        bodies.updateGeometry(row);
+        broadphase->setProxyMoving(slot, false, bodies.bounds[row]);
+    }
+    
+    // 从大到小换到醒着区的末尾，换进来的总是留下醒着的物体
+    for (auto it = sleepingRows.rbegin(); it != sleepingRows.rend(); ++it) {
+        swapRows(*it, awakeCount - 1);
+        awakeCount--;
     }
+    bodyListVersion++;
 }
@@ -1,21 +1,32 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <algorithm>
 #include <glm/glm.hpp>
-#include <vulkan/vulkan.h>
+#include "Broadphase.h"
+#include "BodyStore.h"
+#include "JobSystem.h"
+#include "Integrator.h"
+#include "ContactSolver.h"
+
+class PhysicsEngine;
 
 // Physics Object Class
+// Thin handle onto a row of a BodyStore. A new object keeps its state in a private one-body store;
+// PhysicsEngine::addObject moves that state into the engine's store and the handle follows it.
 class PhysicsObject {
 public:
-    struct Vertex {
-        glm::vec2 position;
-        glm::vec3 color;
-    };
+    using Vertex = BodyVertex;
 
+    // Vertex lists are interned in ShapeLibrary::shared(), so identical objects share one shape
     PhysicsObject(const std::vector<Vertex>& vertices, float mass = 1.0f);
+    PhysicsObject(ShapeRef shape, float mass = 1.0f);
     ~PhysicsObject();
+    PhysicsObject(const PhysicsObject&) = delete;
+    PhysicsObject& operator=(const PhysicsObject&) = delete;
 
-    // Physics property setters
+    // Physics property setters. On a body in an engine these (and applyForce/applyImpulse) wake
+    // the body's island if it is asleep.
     void setPosition(const glm::vec2& pos);
     void setVelocity(const glm::vec2& vel);
     void setMass(float m);
@@ -23,12 +34,17 @@ public:
     void setFriction(float f);
     
     // Physics property getters
-    glm::vec2 getPosition() const { return position; }
-    glm::vec2 getVelocity() const { return velocity; }
-    float getMass() const { return mass; }
-    float getElasticity() const { return elasticity; }
-    float getFriction() const { return friction; }
-    const std::vector<Vertex>& getVertices() const { return vertices; }
+    glm::vec2 getPosition() const { return store->positions[index]; }
+    glm::vec2 getVelocity() const { return store->velocities[index]; }
+    float getMass() const { return store->masses[index]; }
+    float getElasticity() const { return store->elasticities[index]; }
+    float getFriction() const { return store->frictions[index]; }
+    std::vector<Vertex> getVertices() const { return store->getWorldVertices(index); } // world space
+    const ShapeRef& getShape() const { return store->shapes[index]; }
+    glm::vec2 getMinBounds() const { return store->bounds[index].min; }
+    glm::vec2 getMaxBounds() const { return store->bounds[index].max; }
+    // Handle in the engine this object was added to (invalid while not in an engine)
+    BodyHandle getHandle() const { return handle; }
     
     // Physics simulation
     void applyForce(const glm::vec2& force);
@@ -41,57 +57,204 @@ public:
     
     // Deformation
     void deform(const glm::vec2& impactPoint, float force);
-    
-    // Rendering
-    void updateVertexBuffer(VkDevice device, VkDeviceMemory vertexBufferMemory);
-    void draw(VkCommandBuffer commandBuffer, VkBuffer vertexBuffer);
+
 
 private:
-    std::vector<Vertex> vertices;
-    std::vector<Vertex> originalVertices;
-    glm::vec2 position;
-    glm::vec2 velocity;
-    glm::vec2 acceleration;
-    float mass;
-    float elasticity;
-    float friction;
-    float deformation;
-    
-    // Bounding box
-    glm::vec2 minBounds;
-    glm::vec2 maxBounds;
-    
-    void updateBounds();
+    friend class PhysicsEngine;
+
+    BodyStore* store;
+    uint32_t index;
+    BodyHandle handle;
+    PhysicsEngine* engine = nullptr;       // engine holding the body, for waking it
+    std::unique_ptr<BodyStore> localStore; // owns the state while not in an engine
+    
+    // View onto a body that was added to an engine without an object
+    PhysicsObject(PhysicsEngine& owner, BodyStore& engineStore, uint32_t row, BodyHandle bodyHandle);
+    
+    void attach(BodyStore& target);
+    void wake();
+    void detach();
     bool pointInTriangle(const glm::vec2& point, const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) const;
 };
 
+// Milliseconds spent in each phase of one update()
+struct StepTimings {
+    double integrate = 0.0;   // forces, integration, ground response, bounds
+    double broadphase = 0.0;
+    double narrowphase = 0.0;
+    double response = 0.0;    // contact solver, deformation and sleeping
+
+    double total() const { return integrate + broadphase + narrowphase + response; }
+};
+
 // Physics Engine Class
+// Has no dependency on the renderer; Vulkan helpers live in PhysicsRender.h.
 class PhysicsEngine {
 public:
     PhysicsEngine();
     ~PhysicsEngine();
     
-    // Add physics objects
-    void addObject(std::shared_ptr<PhysicsObject> obj);
+    // Add physics objects. Adding and removing are O(1) and move rows to keep the awake bodies in
+    // front; removing a sleeping body wakes its island first.
+    BodyHandle addObject(std::shared_ptr<PhysicsObject> obj);
     void removeObject(std::shared_ptr<PhysicsObject> obj);
+    bool removeObject(BodyHandle handle);
+    
+    // Bulk versions over contiguous ranges; outHandles (optional) receives one handle per entry
+    void addObjects(const std::shared_ptr<PhysicsObject>* objs, size_t count, BodyHandle* outHandles = nullptr);
+    void addBodies(const BodyDesc* descs, size_t count, BodyHandle* outHandles = nullptr);
+    void removeObjects(const BodyHandle* handles, size_t count);
+    
+    // Handle lookup. Stale handles (body removed, slot reused) are reported as invalid.
+    bool isValid(BodyHandle handle) const;
+    uint32_t getBodyIndex(BodyHandle handle) const; // row in getBodies(), or BodyHandle::invalidIndex
+    BodyHandle getHandle(uint32_t bodyIndex) const { return {denseToSlot[bodyIndex], slots[denseToSlot[bodyIndex]].generation}; }
+    // Object for a body; bodies added through addBodies get one created on first request
+    std::shared_ptr<PhysicsObject> getObject(BodyHandle handle);
     
     // Physics simulation
+    // One step of deltaTime (variable stepping). The phases run as a task graph on the job system,
+    // integrate -> broadphase -> narrowphase -> response, each split with parallelFor.
     void update(float deltaTime);
-    void setGravity(const glm::vec2& g) { gravity = g; }
-    void setGroundLevel(float level) { groundLevel = level; }
+    // Fixed stepping: adds frameTime to the accumulator and runs as many fixed steps as fit, at most
+    // maxSubSteps; time beyond that is dropped so a slow frame can't snowball. Returns the step count.
+    int advance(float frameTime);
+    void setFixedTimeStep(float step) { fixedTimeStep = step; }
+    float getFixedTimeStep() const { return fixedTimeStep; }
+    void setMaxSubSteps(int steps) { maxSubSteps = std::max(steps, 1); }
+    int getMaxSubSteps() const { return maxSubSteps; }
+    // Fraction of a fixed step left in the accumulator; render bodies at previous + alpha * (current - previous)
+    float getInterpolationAlpha() const { return static_cast<float>(accumulator / fixedTimeStep); }
+    // Both wake every sleeping body, since the bodies may no longer be at rest
+    void setGravity(const glm::vec2& g);
+    void setGroundLevel(float level);
+    
+    // Broadphase selection: spatial hash by default, sweep-and-prune for coherent scenes,
+    // dynamic tree for mixed static/dynamic scenes with very different body sizes. Each body is a
+    // broadphase proxy keyed by its handle slot; a new broadphase gets every current body registered.
+    void setBroadphase(BroadphaseType type);
+    void setBroadphase(std::unique_ptr<Broadphase> newBroadphase);
+    BroadphaseType getBroadphaseType() const { return broadphase->getType(); }
+    Broadphase& getBroadphase() { return *broadphase; }
     
-    // Collision detection and response
+    // Threads used by update(), including the calling thread. Defaults to one per core;
+    // 1 runs the whole step on the calling thread. Results do not depend on the count.
+    void setThreadCount(unsigned count);
+    unsigned getThreadCount() const { return jobs->getThreadCount(); }
+    JobSystem& getJobSystem() { return *jobs; }
+    
+    // Instruction set of the integrator and the contact solver; defaults to the best the CPU supports.
+    // Requests above what the CPU supports are lowered to the detected level.
+    void setSimdLevel(SimdLevel level);
+    SimdLevel getSimdLevel() const { return simdLevel; }
+    
+    // Velocity iterations of the contact solver per step (default 12). Contacts are warm-started
+    // from the previous step, so resting stacks need few iterations.
+    void setSolverIterations(int count) { contactSolver.setIterations(count); }
+    int getSolverIterations() const { return contactSolver.getIterations(); }
+    ContactSolver& getContactSolver() { return contactSolver; }
+    // Separating axis test for polygons, GJK/EPA for rounded shapes; axis and simplex cached per pair
+    const Narrowphase& getNarrowphase() const { return narrowphase; }
+    
+    // Sleeping: bodies linked by contacts form islands (union-find over the step's contacts). When
+    // every body of an island stays below the sleep velocity for the time to sleep, the island
+    // falls asleep: its rows move behind the awake ones, where integration, bounds updates and
+    // pair tests no longer touch them. Sleeping bodies stay in the broadphase as static proxies that
+    // are only tested against awake ones, so two sleepers never form a pair; an awake body touching
+    // one wakes its whole island. Falling asleep and waking reorder rows, so they change
+    // getBodyListVersion(); handles stay valid and the broadphase is not rebuilt.
+    void setSleepingEnabled(bool enabled);
+    bool isSleepingEnabled() const { return sleepingEnabled; }
+    void setSleepVelocity(float velocity) { sleepVelocity = velocity; }
+    float getSleepVelocity() const { return sleepVelocity; }
+    void setTimeToSleep(float seconds) { timeToSleep = seconds; }
+    float getTimeToSleep() const { return timeToSleep; }
+    bool isSleeping(BodyHandle handle) const;
+    // Wakes the island of a body; returns false for invalid handles
+    bool wake(BodyHandle handle);
+    void wakeAll();
+    // Rows [0, getAwakeCount()) of getBodies() are awake, the rest asleep
+    size_t getAwakeCount() const { return awakeCount; }
+    size_t getSleepingIslandCount() const { return sleepingIslands.size() - freeIslands.size(); }
+    
+    // Collision detection and response, using the time step of the last update()
     void checkCollisions();
     
-    // Render all objects
-    void renderAll(VkCommandBuffer commandBuffer, VkBuffer vertexBuffer);
+    // Body data, one row per body; awake rows come first (see getAwakeCount())
+    const BodyStore& getBodies() const { return bodies; }
+    size_t getObjectCount() const { return bodies.size(); }
+    // Changes whenever bodies are added or removed, or rows are reordered by sleeping and waking
+    uint64_t getBodyListVersion() const { return bodyListVersion; }
+    
+    // Wall-clock time of the phases of the last update()
+    const StepTimings& getLastStepTimings() const { return lastStepTimings; }
 
 private:
-    std::vector<std::shared_ptr<PhysicsObject>> objects;
+    struct Slot {
+        uint32_t dense;      // row in bodies, or invalidIndex while free
+        uint32_t generation;
+        uint32_t island;     // sleeping island, or invalidIndex while awake
+    };
+    
+    BodyStore bodies;
+    std::vector<std::shared_ptr<PhysicsObject>> objects; // objects[i] is the handle of bodies row i (may be null)
+    std::vector<uint32_t> denseToSlot;
+    std::vector<uint64_t> bodyKeys;  // per row: generation << 32 | slot; never reused, so cache entries of removed bodies cannot match
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    uint64_t bodyListVersion = 0;
     glm::vec2 gravity;
     float groundLevel;
     float airResistance;
+    SimdLevel simdLevel;
+    
+    float fixedTimeStep;
+    int maxSubSteps;
+    double accumulator;
+    
+    std::unique_ptr<JobSystem> jobs;
+    TaskGraph stepGraph;
+    std::unique_ptr<Broadphase> broadphase;
+    std::vector<BroadphasePair> candidatePairs;
+    std::vector<uint8_t> pairContacts; // narrowphase result per candidate pair
+    std::vector<ContactManifold> pairManifolds;
+    std::vector<Narrowphase::PairCache> pairCaches;
+    Narrowphase narrowphase;
+    std::vector<ContactManifold> contacts;
+    ContactSolver contactSolver;
+    float stepDeltaTime;
+    
+    uint32_t awakeCount = 0;
+    bool sleepingEnabled = true;
+    float sleepVelocity;
+    float timeToSleep;
+    std::vector<std::vector<uint32_t>> sleepingIslands;  // slots of the bodies of each sleeping island
+    std::vector<uint32_t> freeIslands;
+    std::vector<uint32_t> islandParents;                 // union-find over the awake rows
+    std::vector<float> islandSleepTimes;                 // per root: shortest sleep time in the island
+    std::vector<uint32_t> rootIslands;                   // per root: sleeping island it goes to
+    std::vector<uint32_t> sleepingRows;
+    std::vector<uint32_t> wokenIslands;
+    StepTimings lastStepTimings;
+    
+    BodyHandle allocateSlot(uint32_t dense);
+    // Moves a newly appended body in front of the sleeping rows
+    void insertAwake(uint32_t dense);
+    void removeBodyAt(uint32_t dense);
+    void swapRows(uint32_t i, uint32_t j);
+    void wakeIsland(uint32_t island);
+    // Wakes islands that awake bodies ran into and drops contacts that stay asleep
+    void wakeTouchedIslands();
+    // Builds islands from the step's contacts and puts the ones at rest to sleep
+    void updateSleeping(float deltaTime);
+    
+    // Per-step pass over the body rows [begin, end)
+    void updateGeometry(uint32_t begin, uint32_t end);
     
-    void applyGroundCollision(std::shared_ptr<PhysicsObject> obj);
-    void applyAirResistance(std::shared_ptr<PhysicsObject> obj);
+    // Phases of update(), the tasks of stepGraph
+    void buildStepGraph();
+    void integrateStep();
+    void runBroadphase();
+    void runNarrowphase();
+    void respond();
 };
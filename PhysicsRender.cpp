@@ -0,0 +1,33 @@
+#include "PhysicsRender.h"
+#include <cstring>
+
+void updateVertexBuffer(const PhysicsObject& object, VkDevice device, VkDeviceMemory vertexBufferMemory) {
+    // 更新GPU内存中的顶点数据
+    std::vector<PhysicsObject::Vertex> vertices = object.getVertices();
+    void* data;
+    vkMapMemory(device, vertexBufferMemory, 0, vertices.size() * sizeof(PhysicsObject::Vertex), 0, &data);
+    memcpy(data, vertices.data(), vertices.size() * sizeof(PhysicsObject::Vertex));
+    vkUnmapMemory(device, vertexBufferMemory);
+}
+
+void drawObject(const PhysicsObject& object, VkCommandBuffer commandBuffer, VkBuffer vertexBuffer) {
+    VkBuffer vertexBuffers[] = {vertexBuffer};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    vkCmdDraw(commandBuffer, static_cast<uint32_t>(object.getVertices().size()), 1, 0, 0);
+}
+
+void renderAll(const PhysicsEngine& engine, VkCommandBuffer commandBuffer, VkBuffer vertexBuffer) {
+    VkBuffer vertexBuffers[] = {vertexBuffer};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+    // 每个物体的顶点在缓冲区里依次排列
+    const BodyStore& bodies = engine.getBodies();
+    uint32_t firstVertex = 0;
+    for (uint32_t i = 0; i < bodies.size(); i++) {
+        uint32_t count = static_cast<uint32_t>(bodies.getVertexCount(i));
+        vkCmdDraw(commandBuffer, count, 1, firstVertex, 0);
+        firstVertex += count;
+    }
+}
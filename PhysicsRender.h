@@ -0,0 +1,13 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "PhysicsEngine.h"
+
+// Vulkan helpers for drawing physics bodies. Kept apart from PhysicsEngine so the physics
+// library builds without Vulkan.
+
+// Uploads the object's world-space vertices to the start of the buffer memory
+void updateVertexBuffer(const PhysicsObject& object, VkDevice device, VkDeviceMemory vertexBufferMemory);
+void drawObject(const PhysicsObject& object, VkCommandBuffer commandBuffer, VkBuffer vertexBuffer);
+
+// Draws every body of the engine from a buffer holding their vertices back to back, in body order
+void renderAll(const PhysicsEngine& engine, VkCommandBuffer commandBuffer, VkBuffer vertexBuffer);
@@ -0,0 +1,170 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 字段用 relaxed 原子变量，导出时和写线程并发读取不算数据竞争
+struct ProfileEvent {
+    std::atomic<const char*> name{nullptr};
+    std::atomic<int64_t> start{0};
+    std::atomic<int64_t> end{0};
+};
+
+struct ThreadBuffer {
+    std::string name;
+    uint32_t id = 0;
+    std::unique_ptr<ProfileEvent[]> events{new ProfileEvent[Profiler::eventsPerThread]};
+    std::atomic<uint64_t> written{0};
+    uint64_t clearedBefore = 0; // 受 Registry::mutex 保护
+};
+
+struct Registry {
+    std::mutex mutex;
+    // 线程退出后缓冲区仍保留，退出时还能导出它的记录
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    Clock::time_point epoch = Clock::now();
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+thread_local ThreadBuffer* currentBuffer = nullptr;
+
+// 调用者需持有 Registry::mutex
+ThreadBuffer& addBuffer(Registry& reg, const std::string& name) {
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->id = static_cast<uint32_t>(reg.buffers.size());
+    buffer->name = name.empty() ? "thread " + std::to_string(buffer->id) : name;
+    reg.buffers.push_back(std::move(buffer));
+    return *reg.buffers.back();
+}
+
+ThreadBuffer& threadBuffer() {
+    if (!currentBuffer) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        currentBuffer = &addBuffer(reg, "");
+    }
+    return *currentBuffer;
+}
+
+void writeEvent(ThreadBuffer& buffer, const char* name, int64_t start, int64_t end) {
+    uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    ProfileEvent& event = buffer.events[index & (Profiler::eventsPerThread - 1)];
+
+    // 和导出线程配对的 seqlock：先发布“正在写 index”，再写内容
+    std::atomic_thread_fence(std::memory_order_release);
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+int64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - registry().epoch).count();
+}
+
+void Profiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    buffer.name = name;
+}
+
+void Profiler::record(const char* name, int64_t start, int64_t end) {
+    writeEvent(threadBuffer(), name, start, end);
+}
+
+uint32_t Profiler::createTrack(const std::string& name) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return addBuffer(reg, name).id;
+}
+
+void Profiler::recordOnTrack(uint32_t track, const char* name, int64_t start, int64_t end) {
+    ThreadBuffer* buffer;
+    {
+        // 缓冲区由 unique_ptr 持有，地址不变，取到指针后即可放锁
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        if (track >= reg.buffers.size()) return;
+        buffer = reg.buffers[track].get();
+    }
+    writeEvent(*buffer, name, start, end);
+}
+
+void Profiler::writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("failed to write trace file: " + path);
+    }
+
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"VisualPhysicsEngine\"}}";
+    file << std::fixed << std::setprecision(3);
+
+    std::vector<std::pair<const char*, std::pair<int64_t, int64_t>>> copied;
+    for (const auto& buffer : reg.buffers) {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+        writeJsonString(file, buffer->name);
+        file << "}}";
+
+        // 先复制，再检查复制期间哪些槽位可能被覆盖
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t first = std::max(written > eventsPerThread ? written - eventsPerThread : 0, buffer->clearedBefore);
+        copied.clear();
+        for (uint64_t i = first; i < written; i++) {
+            const ProfileEvent& event = buffer->events[i & (eventsPerThread - 1)];
+            copied.push_back({event.name.load(std::memory_order_relaxed),
+                              {event.start.load(std::memory_order_relaxed), event.end.load(std::memory_order_relaxed)}});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t writtenAfter = buffer->written.load(std::memory_order_relaxed);
+        uint64_t firstValid = writtenAfter >= eventsPerThread ? writtenAfter - eventsPerThread + 1 : 0;
+
+        for (uint64_t i = std::max(first, firstValid); i < written; i++) {
+            const auto& event = copied[i - first];
+            file << ",\n{\"name\":";
+            writeJsonString(file, event.first);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id << ",\"ts\":" << event.second.first / 1000.0
+                 << ",\"dur\":" << (event.second.second - event.second.first) / 1000.0 << "}";
+        }
+    }
+    file << "\n]}\n";
+    if (!file) {
+        throw std::runtime_error("failed to write trace file: " + path);
+    }
+}
+
+void Profiler::clear() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    // 只有所属线程会写 written，这里只记下导出的起点
+    for (auto& buffer : reg.buffers) {
+        buffer->clearedBefore = buffer->written.load(std::memory_order_acquire);
+    }
+}
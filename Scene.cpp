@@ -0,0 +1,209 @@
+#include "Scene.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::vector<BodyVertex> makeTriangle(float size, const glm::vec3& color) {
+    return {
+        {{0.0f, size}, color},
+        {{-size, -size}, color},
+        {{size, -size}, color},
+    };
+}
+
+std::vector<BodyVertex> makeBox(float halfSize, const glm::vec3& color) {
+    glm::vec2 a(-halfSize, -halfSize), b(halfSize, -halfSize), c(halfSize, halfSize), d(-halfSize, halfSize);
+    return {{a, color}, {b, color}, {c, color}, {a, color}, {c, color}, {d, color}};
+}
+
+std::runtime_error parseError(const std::string& path, int line, const std::string& message) {
+    return std::runtime_error(path + ":" + std::to_string(line) + ": " + message);
+}
+
+} // namespace
+
+Scene Scene::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("failed to open scene file: " + path);
+    }
+
+    Scene scene;
+    std::map<std::string, ShapeRef> shapes;
+    std::string text;
+    int lineNumber = 0;
+    while (std::getline(file, text)) {
+        lineNumber++;
+        size_t comment = text.find('#');
+        if (comment != std::string::npos) text.erase(comment);
+
+        std::istringstream line(text);
+        std::string keyword;
+        if (!(line >> keyword)) continue;
+
+        if (keyword == "gravity") {
+            if (!(line >> scene.gravity.x >> scene.gravity.y)) throw parseError(path, lineNumber, "expected gravity <x> <y>");
+        } else if (keyword == "ground") {
+            if (!(line >> scene.groundLevel)) throw parseError(path, lineNumber, "expected ground <y>");
+        } else if (keyword == "shape") {
+            std::string name;
+            size_t count = 0;
+            if (!(line >> name >> count)) throw parseError(path, lineNumber, "expected shape <name> <vertexCount> ...");
+            std::vector<BodyVertex> vertices(count);
+            for (auto& vertex : vertices) {
+                if (!(line >> vertex.position.x >> vertex.position.y >> vertex.color.r >> vertex.color.g >> vertex.color.b)) {
+                    throw parseError(path, lineNumber, "shape " + name + " has fewer than " + std::to_string(count) + " vertices");
+                }
+            }
+            shapes[name] = ShapeLibrary::shared().get(vertices);
+        } else if (keyword == "round") {
+            std::string name;
+            float radius = 0.0f;
+            size_t coreCount = 0;
+            if (!(line >> name >> radius >> coreCount) || radius < 0.0f || coreCount == 0) {
+                throw parseError(path, lineNumber, "expected round <name> <radius> <coreCount> ...");
+            }
+            std::vector<glm::vec2> core(coreCount);
+            for (auto& point : core) {
+                if (!(line >> point.x >> point.y)) {
+                    throw parseError(path, lineNumber, "round " + name + " has fewer than " + std::to_string(coreCount) + " core points");
+                }
+            }
+            size_t count = 0;
+            if (!(line >> count)) throw parseError(path, lineNumber, "round " + name + " needs <vertexCount> ...");
+            std::vector<BodyVertex> vertices(count);
+            for (auto& vertex : vertices) {
+                if (!(line >> vertex.position.x >> vertex.position.y >> vertex.color.r >> vertex.color.g >> vertex.color.b)) {
+                    throw parseError(path, lineNumber, "round " + name + " has fewer than " + std::to_string(count) + " vertices");
+                }
+            }
+            shapes[name] = ShapeLibrary::shared().get(vertices, core, radius);
+        } else if (keyword == "body") {
+            std::string shapeName;
+            BodyDesc desc;
+            if (!(line >> shapeName >> desc.mass >> desc.position.x >> desc.position.y)) {
+                throw parseError(path, lineNumber, "expected body <shape> <mass> <x> <y>");
+            }
+            auto shape = shapes.find(shapeName);
+            if (shape == shapes.end()) throw parseError(path, lineNumber, "unknown shape " + shapeName);
+            desc.shape = shape->second;
+
+            // 可选字段
+            if (line >> desc.velocity.x) {
+                if (!(line >> desc.velocity.y)) throw parseError(path, lineNumber, "velocity needs <vx> <vy>");
+                if (line >> desc.elasticity) {
+                    if (!(line >> desc.friction)) throw parseError(path, lineNumber, "expected <elasticity> <friction>");
+                }
+            }
+            scene.bodies.push_back(std::move(desc));
+        } else {
+            throw parseError(path, lineNumber, "unknown keyword " + keyword);
+        }
+    }
+    return scene;
+}
+
+void Scene::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("failed to write scene file: " + path);
+    }
+
+    // 相同的形状只写一次
+    std::map<const Shape*, std::string> shapeNames;
+    std::vector<ShapeRef> ownedShapes;
+    file.precision(9);
+    file << "gravity " << gravity.x << " " << gravity.y << "\n";
+    file << "ground " << groundLevel << "\n";
+    for (const auto& desc : bodies) {
+        ShapeRef shape = desc.shape ? desc.shape : ShapeLibrary::shared().get(desc.vertices);
+        auto found = shapeNames.find(shape.get());
+        if (found == shapeNames.end()) {
+            std::string name = "s" + std::to_string(shapeNames.size());
+            found = shapeNames.emplace(shape.get(), name).first;
+            ownedShapes.push_back(shape);
+
+            if (shape->isRounded()) {
+                file << "round " << name << " " << shape->getRadius() << " " << shape->getCore().size();
+                for (const auto& point : shape->getCore()) {
+                    file << "  " << point.x << " " << point.y;
+                }
+                file << "  " << shape->getVertices().size();
+            } else {
+                file << "shape " << name << " " << shape->getVertices().size();
+            }
+            for (const auto& vertex : shape->getVertices()) {
+                file << "  " << vertex.position.x << " " << vertex.position.y << " "
+                     << vertex.color.r << " " << vertex.color.g << " " << vertex.color.b;
+            }
+            file << "\n";
+        }
+        file << "body " << found->second << " " << desc.mass << " " << desc.position.x << " " << desc.position.y << " "
+             << desc.velocity.x << " " << desc.velocity.y << " " << desc.elasticity << " " << desc.friction << "\n";
+    }
+}
+
+Scene Scene::generate(const std::string& kind, size_t bodyCount, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    Scene scene;
+    scene.bodies.resize(bodyCount);
+
+    // 几种尺寸的形状循环使用，大量物体共享少量形状
+    const glm::vec3 colors[] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {1.0f, 1.0f, 0.0f}};
+    std::vector<ShapeRef> shapes;
+    for (int i = 0; i < 4; i++) {
+        float size = 0.01f + 0.005f * i;
+        shapes.push_back(ShapeLibrary::shared().get(i % 2 == 0 ? makeTriangle(size, colors[i]) : makeBox(size, colors[i])));
+    }
+
+    if (kind == "round") {
+        // 圆、胶囊和圆角方块，像 rain 一样散落
+        ShapeLibrary& library = ShapeLibrary::shared();
+        shapes = {library.getCircle(0.012f, colors[0]), library.getCapsule(0.012f, 0.008f, colors[1]),
+                  library.getRoundedBox(glm::vec2(0.01f), 0.004f, colors[2]), library.getCircle(0.018f, colors[3])};
+    }
+
+    if (kind == "rain" || kind == "round") {
+        float width = std::sqrt(static_cast<float>(bodyCount)) * 0.1f;
+        for (size_t i = 0; i < bodyCount; i++) {
+            BodyDesc& desc = scene.bodies[i];
+            desc.shape = shapes[i % shapes.size()];
+            desc.position = glm::vec2((unit(rng) * 2.0f - 1.0f) * width, scene.groundLevel + 0.3f + unit(rng) * 2.5f);
+            desc.velocity = glm::vec2(unit(rng) - 0.5f, unit(rng) - 0.5f) * 0.4f;
+        }
+    } else if (kind == "pile") {
+        int columns = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(bodyCount)) * 0.5f));
+        for (size_t i = 0; i < bodyCount; i++) {
+            BodyDesc& desc = scene.bodies[i];
+            desc.shape = shapes[i % shapes.size()];
+            float x = (static_cast<int>(i % columns) - columns * 0.5f) * 0.035f + (unit(rng) - 0.5f) * 0.005f;
+            float y = scene.groundLevel + 0.02f + static_cast<float>(i / columns) * 0.035f;
+            desc.position = glm::vec2(x, y);
+        }
+    } else if (kind == "grid") {
+        int columns = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(bodyCount)) * 2.0f));
+        for (size_t i = 0; i < bodyCount; i++) {
+            BodyDesc& desc = scene.bodies[i];
+            desc.shape = shapes[i % shapes.size()];
+            float x = (static_cast<int>(i % columns) - columns * 0.5f) * 0.05f;
+            float y = scene.groundLevel + static_cast<float>(i / columns) * 0.05f;
+            desc.position = glm::vec2(x, y);
+        }
+    } else {
+        throw std::runtime_error("unknown scene kind: " + kind + " (expected rain, pile, grid or round)");
+    }
+    return scene;
+}
+
+void Scene::applyTo(PhysicsEngine& engine) const {
+    engine.setGravity(gravity);
+    engine.setGroundLevel(groundLevel);
+    engine.addBodies(bodies.data(), bodies.size());
+}
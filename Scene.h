@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "PhysicsEngine.h"
+
+// Bodies and world settings of a simulation, independent of any engine instance.
+//
+// Text format, one entry per line ('#' starts a comment):
+//   gravity <x> <y>
+//   ground <y>
+//   shape <name> <vertexCount> <x y r g b>...        vertices form a triangle list
+//   round <name> <radius> <coreCount> <x y>... <vertexCount> <x y r g b>...
+//                                                   collides as the core points inflated by radius
+//   body <shape> <mass> <x> <y> [<vx> <vy> [<elasticity> <friction>]]
+struct Scene {
+    glm::vec2 gravity = glm::vec2(0.0f, -9.8f);
+    float groundLevel = -0.8f;
+    std::vector<BodyDesc> bodies;
+
+    // Throws std::runtime_error on unreadable files or malformed lines
+    static Scene load(const std::string& path);
+    void save(const std::string& path) const;
+
+    // Built-in scenes: "rain" (bodies scattered above the ground), "pile" (dense column that
+    // collapses), "grid" (resting rows on the ground) and "round" (rain of circles, capsules and
+    // rounded boxes). Throws on unknown names.
+    static Scene generate(const std::string& kind, size_t bodyCount, uint32_t seed);
+
+    // Sets gravity and ground level and adds all bodies
+    void applyTo(PhysicsEngine& engine) const;
+};
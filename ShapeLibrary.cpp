@@ -0,0 +1,246 @@
+#include "ShapeLibrary.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// FNV-1a，对顶点数据的原始字节求哈希
+uint64_t hashVertices(const std::vector<BodyVertex>& vertices) {
+    uint64_t hash = 1469598103934665603ull;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(vertices.data());
+    for (size_t i = 0; i < vertices.size() * sizeof(BodyVertex); i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+float cross(const glm::vec2& o, const glm::vec2& a, const glm::vec2& b) {
+    return (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+}
+
+// Andrew 单调链，逆时针，去掉共线点
+std::vector<glm::vec2> convexHull(const std::vector<BodyVertex>& vertices) {
+    std::vector<glm::vec2> points;
+    points.reserve(vertices.size());
+    for (const auto& vertex : vertices) points.push_back(vertex.position);
+    std::sort(points.begin(), points.end(), [](const glm::vec2& lhs, const glm::vec2& rhs) {
+        return lhs.x < rhs.x || (lhs.x == rhs.x && lhs.y < rhs.y);
+    });
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    if (points.size() < 3) return {};
+
+    std::vector<glm::vec2> hull(points.size() * 2);
+    size_t count = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        while (count >= 2 && cross(hull[count - 2], hull[count - 1], points[i]) <= 0.0f) count--;
+        hull[count++] = points[i];
+    }
+    for (size_t i = points.size() - 1, lower = count + 1; i-- > 0;) {
+        while (count >= lower && cross(hull[count - 2], hull[count - 1], points[i]) <= 0.0f) count--;
+        hull[count++] = points[i];
+    }
+    // 最后一个点和第一个重复
+    hull.resize(count - 1);
+    if (hull.size() < 3) return {};
+    return hull;
+}
+
+// 圆角形状再混入核心点和半径
+uint64_t hashRounded(uint64_t hash, const std::vector<glm::vec2>& core, float radius) {
+    auto mix = [&](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    mix(core.data(), core.size() * sizeof(glm::vec2));
+    mix(&radius, sizeof(radius));
+    return hash;
+}
+
+bool sameVertices(const std::vector<BodyVertex>& lhs, const std::vector<BodyVertex>& rhs) {
+    return lhs.size() == rhs.size() && std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(BodyVertex)) == 0;
+}
+
+bool sameShape(const Shape& shape, const std::vector<BodyVertex>& vertices, const std::vector<glm::vec2>* core, float radius) {
+    if (!sameVertices(shape.getVertices(), vertices) || shape.isRounded() != (core != nullptr)) return false;
+    return !core || (shape.getRadius() == radius && shape.getCore() == *core);
+}
+
+// 以原点为中心的扇形三角形列表，outline 按逆时针排列
+std::vector<BodyVertex> fanTriangles(const std::vector<glm::vec2>& outline, const glm::vec3& color) {
+    std::vector<BodyVertex> vertices;
+    vertices.reserve(outline.size() * 3);
+    for (size_t i = 0; i < outline.size(); i++) {
+        vertices.push_back({glm::vec2(0.0f), color});
+        vertices.push_back({outline[i], color});
+        vertices.push_back({outline[(i + 1) % outline.size()], color});
+    }
+    return vertices;
+}
+
+// 圆弧上的点，从 startAngle 起逆时针，包含两端
+void appendArc(std::vector<glm::vec2>& outline, const glm::vec2& center, float radius, float startAngle, int segments) {
+    const float step = 1.57079632679f / static_cast<float>(segments);
+    for (int i = 0; i <= segments; i++) {
+        float angle = startAngle + step * static_cast<float>(i);
+        outline.push_back(center + radius * glm::vec2(std::cos(angle), std::sin(angle)));
+    }
+}
+
+// 每四分之一圆的段数
+constexpr int arcSegments = 8;
+
+} // namespace
+
+// Shape 实现
+Shape::Shape(std::vector<BodyVertex> verts)
+    : vertices(std::move(verts)), localBounds{glm::vec2(0.0f), glm::vec2(0.0f)}, area(0.0f),
+      centroid(0.0f), unitInertia(0.0f), hash(hashVertices(vertices)) {
+    if (vertices.empty()) return;
+
+    // 逆时针的边 (x, y) 的外法线是 (y, -x)
+    hull = convexHull(vertices);
+    hullNormals.resize(hull.size());
+    for (size_t i = 0; i < hull.size(); i++) {
+        glm::vec2 edge = hull[(i + 1) % hull.size()] - hull[i];
+        hullNormals[i] = glm::normalize(glm::vec2(edge.y, -edge.x));
+    }
+
+    localBounds = {vertices[0].position, vertices[0].position};
+    for (const auto& vertex : vertices) {
+        localBounds.min = glm::min(localBounds.min, vertex.position);
+        localBounds.max = glm::max(localBounds.max, vertex.position);
+    }
+
+    // 按三角形累加面积、一阶矩和对原点的二阶矩
+    double totalArea = 0.0;
+    double momentX = 0.0;
+    double momentY = 0.0;
+    double inertia = 0.0;
+    for (size_t t = 0; t + 3 <= vertices.size(); t += 3) {
+        glm::dvec2 a = vertices[t].position;
+        glm::dvec2 b = vertices[t + 1].position;
+        glm::dvec2 c = vertices[t + 2].position;
+        double triangleArea = std::abs((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y)) * 0.5;
+
+        totalArea += triangleArea;
+        momentX += triangleArea * (a.x + b.x + c.x) / 3.0;
+        momentY += triangleArea * (a.y + b.y + c.y) / 3.0;
+        inertia += triangleArea / 6.0 *
+                   (glm::dot(a, a) + glm::dot(b, b) + glm::dot(c, c) + glm::dot(a, b) + glm::dot(b, c) + glm::dot(c, a));
+    }
+
+    if (totalArea > 0.0) {
+        glm::dvec2 center(momentX / totalArea, momentY / totalArea);
+        area = static_cast<float>(totalArea);
+        centroid = glm::vec2(center);
+        // 平行轴定理移到质心，再除以面积得到单位质量的转动惯量
+        unitInertia = static_cast<float>((inertia - totalArea * glm::dot(center, center)) / totalArea);
+    } else {
+        // 退化的形状用包围盒中心
+        centroid = (localBounds.min + localBounds.max) * 0.5f;
+    }
+}
+
+Shape::Shape(std::vector<BodyVertex> verts, std::vector<glm::vec2> corePoints, float coreRadius)
+    : Shape(std::move(verts)) {
+    core = std::move(corePoints);
+    radius = coreRadius;
+    rounded = true;
+    hash = hashRounded(hash, core, radius);
+}
+
+// ShapeLibrary 实现
+ShapeLibrary& ShapeLibrary::shared() {
+    static ShapeLibrary library;
+    return library;
+}
+
+ShapeRef ShapeLibrary::get(const std::vector<BodyVertex>& vertices) {
+    return intern(vertices, nullptr, 0.0f);
+}
+
+ShapeRef ShapeLibrary::get(const std::vector<BodyVertex>& vertices, const std::vector<glm::vec2>& core, float radius) {
+    return intern(vertices, &core, radius);
+}
+
+ShapeRef ShapeLibrary::getCircle(float radius, const glm::vec3& color) {
+    std::vector<glm::vec2> outline;
+    for (int quarter = 0; quarter < 4; quarter++) {
+        appendArc(outline, glm::vec2(0.0f), radius, 1.57079632679f * quarter, arcSegments);
+        outline.pop_back();
+    }
+    return get(fanTriangles(outline, color), {glm::vec2(0.0f)}, radius);
+}
+
+ShapeRef ShapeLibrary::getCapsule(float halfLength, float radius, const glm::vec3& color) {
+    std::vector<glm::vec2> outline;
+    // 两端各一个半圆，中间的直边由相邻的点连成
+    appendArc(outline, glm::vec2(halfLength, 0.0f), radius, -1.57079632679f, arcSegments);
+    outline.pop_back();
+    appendArc(outline, glm::vec2(halfLength, 0.0f), radius, 0.0f, arcSegments);
+    appendArc(outline, glm::vec2(-halfLength, 0.0f), radius, 1.57079632679f, arcSegments);
+    outline.pop_back();
+    appendArc(outline, glm::vec2(-halfLength, 0.0f), radius, 3.14159265359f, arcSegments);
+    return get(fanTriangles(outline, color), {glm::vec2(-halfLength, 0.0f), glm::vec2(halfLength, 0.0f)}, radius);
+}
+
+ShapeRef ShapeLibrary::getRoundedBox(const glm::vec2& halfExtents, float radius, const glm::vec3& color) {
+    const glm::vec2 corners[] = {{halfExtents.x, -halfExtents.y}, {halfExtents.x, halfExtents.y},
+                                 {-halfExtents.x, halfExtents.y}, {-halfExtents.x, -halfExtents.y}};
+    std::vector<glm::vec2> outline;
+    for (int i = 0; i < 4; i++) {
+        appendArc(outline, corners[i], radius, 1.57079632679f * (i - 1), arcSegments);
+    }
+    return get(fanTriangles(outline, color), std::vector<glm::vec2>(corners, corners + 4), radius);
+}
+
+ShapeRef ShapeLibrary::intern(const std::vector<BodyVertex>& vertices, const std::vector<glm::vec2>* core, float radius) {
+    uint64_t hash = hashVertices(vertices);
+    if (core) hash = hashRounded(hash, *core, radius);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto range = shapes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        ShapeRef shape = it->second.lock();
+        if (shape && sameShape(*shape, vertices, core, radius)) {
+            return shape;
+        }
+    }
+
+    ShapeRef shape = core ? std::make_shared<const Shape>(vertices, *core, radius) : std::make_shared<const Shape>(vertices);
+    shapes.emplace(hash, shape);
+
+    // 条目数翻倍时清理一次已经释放的形状
+    if (shapes.size() >= purgeThreshold) {
+        purgeLocked();
+        purgeThreshold = std::max<size_t>(64, shapes.size() * 2);
+    }
+    return shape;
+}
+
+size_t ShapeLibrary::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& entry : shapes) {
+        if (!entry.second.expired()) count++;
+    }
+    return count;
+}
+
+void ShapeLibrary::purge() {
+    std::lock_guard<std::mutex> lock(mutex);
+    purgeLocked();
+}
+
+void ShapeLibrary::purgeLocked() {
+    for (auto it = shapes.begin(); it != shapes.end();) {
+        if (it->second.expired()) {
+            it = shapes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
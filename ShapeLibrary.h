@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "AABB.h"
+
+// Render vertex of a body (PhysicsObject::Vertex)
+struct BodyVertex {
+    glm::vec2 position;
+    glm::vec3 color;
+};
+
+// Immutable body geometry in local space, shared by every body that uses it. The vertex list is
+// a triangle list (as drawn); mass properties are integrated over those triangles, and collision
+// uses their convex hull. Round shapes (circles, capsules, rounded boxes) are drawn tessellated
+// but collide as the convex hull of a few core points inflated by a radius.
+class Shape {
+public:
+    explicit Shape(std::vector<BodyVertex> vertices);
+    Shape(std::vector<BodyVertex> vertices, std::vector<glm::vec2> core, float radius);
+
+    const std::vector<BodyVertex>& getVertices() const { return vertices; }
+    const AABB& getLocalBounds() const { return localBounds; }
+    float getArea() const { return area; }
+    glm::vec2 getCentroid() const { return centroid; }
+    // Polar moment of inertia about the centroid for unit mass; scale by the body mass
+    float getUnitInertia() const { return unitInertia; }
+    uint64_t getHash() const { return hash; }
+    // Convex hull, counter-clockwise without collinear points; normals[i] is the outward normal
+    // of the edge from hull[i] to hull[i + 1]. Empty if the vertices span no area.
+    const std::vector<glm::vec2>& getHull() const { return hull; }
+    const std::vector<glm::vec2>& getHullNormals() const { return hullNormals; }
+    // Collision core: the hull for polygons, the given points for round shapes
+    const std::vector<glm::vec2>& getCore() const { return rounded ? core : hull; }
+    float getRadius() const { return radius; }
+    bool isRounded() const { return rounded; }
+
+private:
+    std::vector<BodyVertex> vertices;
+    std::vector<glm::vec2> hull;
+    std::vector<glm::vec2> hullNormals;
+    std::vector<glm::vec2> core;
+    float radius = 0.0f;
+    bool rounded = false;
+    AABB localBounds;
+    float area;
+    glm::vec2 centroid;
+    float unitInertia;
+    uint64_t hash;
+};
+
+using ShapeRef = std::shared_ptr<const Shape>;
+
+// Interns shapes by content: asking twice for the same vertex list returns the same Shape.
+// Entries are weak, so a shape is freed once the last body using it is gone.
+class ShapeLibrary {
+public:
+    // Library used when bodies are created straight from a vertex list
+    static ShapeLibrary& shared();
+
+    ShapeRef get(const std::vector<BodyVertex>& vertices);
+    ShapeRef get(const std::vector<BodyVertex>& vertices, const std::vector<glm::vec2>& core, float radius);
+    // Round shapes, tessellated for drawing. The capsule lies along x.
+    ShapeRef getCircle(float radius, const glm::vec3& color);
+    ShapeRef getCapsule(float halfLength, float radius, const glm::vec3& color);
+    ShapeRef getRoundedBox(const glm::vec2& halfExtents, float radius, const glm::vec3& color);
+    // Shapes still referenced by some body
+    size_t size() const;
+    // Drops entries whose shape has been freed
+    void purge();
+
+private:
+    mutable std::mutex mutex;
+    std::unordered_multimap<uint64_t, std::weak_ptr<const Shape>> shapes;
+    size_t purgeThreshold = 64;
+
+    void purgeLocked();
+    ShapeRef intern(const std::vector<BodyVertex>& vertices, const std::vector<glm::vec2>* core, float radius);
+};
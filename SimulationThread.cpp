@@ -0,0 +1,148 @@
+#include "SimulationThread.h"
+#include "Profiler.h"
+#include <algorithm>
+
+// RenderSnapshot 实现
+void RenderSnapshot::capture(const PhysicsEngine& engine, uint64_t steps) {
+    const BodyStore& bodies = engine.getBodies();
+
+    positions.assign(bodies.positions.begin(), bodies.positions.end());
+    previousPositions.assign(bodies.previousPositions.begin(), bodies.previousPositions.end());
+
+    // 物体列表没变时不用重新复制形状，省掉引用计数的原子操作
+    if (bodyListVersion != engine.getBodyListVersion()) {
+        shapes.assign(bodies.shapes.begin(), bodies.shapes.end());
+        bodyListVersion = engine.getBodyListVersion();
+        vertexCount = 0;
+        for (const auto& shape : shapes) {
+            vertexCount += shape->getVertices().size();
+        }
+    }
+
+    deformedBodies.clear();
+    deformedOffsets.clear();
+    deformedVertices.clear();
+    for (uint32_t i = 0; i < bodies.size(); i++) {
+        if (!bodies.deformed[i]) continue;
+        deformedBodies.push_back(i);
+        deformedOffsets.push_back(deformedVertices.size());
+        deformedVertices.insert(deformedVertices.end(), bodies.deformedVertices[i].begin(), bodies.deformedVertices[i].end());
+    }
+
+    stepCount = steps;
+    fixedTimeStep = engine.getFixedTimeStep();
+    alpha = engine.getInterpolationAlpha();
+    publishTime = Clock::now();
+}
+
+float RenderSnapshot::getAlphaAt(Clock::time_point now) const {
+    if (fixedTimeStep <= 0.0f) return 1.0f;
+    float elapsed = std::chrono::duration<float>(now - publishTime).count();
+    return std::clamp(alpha + elapsed / fixedTimeStep, 0.0f, 1.0f);
+}
+
+void RenderSnapshot::copyVertices(BodyVertex* out, float renderAlpha) const {
+    size_t nextDeformed = 0;
+    const BodyVertex* deformedSource = deformedVertices.data();
+
+    for (uint32_t i = 0; i < positions.size(); i++) {
+        glm::vec2 position = renderAlpha >= 1.0f ? positions[i] : glm::mix(previousPositions[i], positions[i], renderAlpha);
+        const std::vector<BodyVertex>& local = shapes[i]->getVertices();
+
+        if (nextDeformed < deformedBodies.size() && deformedBodies[nextDeformed] == i) {
+            // 变形后的顶点是按当前位置生成的，整体平移到插值位置
+            glm::vec2 offset = position - positions[i];
+            for (size_t v = 0; v < local.size(); v++) {
+                out[v].position = deformedSource[v].position + offset;
+                out[v].color = deformedSource[v].color;
+            }
+            deformedSource += local.size();
+            nextDeformed++;
+        } else {
+            for (size_t v = 0; v < local.size(); v++) {
+                out[v].position = local[v].position + position;
+                out[v].color = local[v].color;
+            }
+        }
+        out += local.size();
+    }
+}
+
+// SimulationThread 实现
+SimulationThread::SimulationThread(PhysicsEngine& physicsEngine) : engine(physicsEngine) {
+    publish();
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::start() {
+    if (running.exchange(true)) return;
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+    runCommands();
+}
+
+void SimulationThread::post(std::function<void(PhysicsEngine&)> command) {
+    if (!isRunning()) {
+        command(engine);
+        publish();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(commandMutex);
+    commands.push_back(std::move(command));
+}
+
+bool SimulationThread::runCommands() {
+    {
+        std::lock_guard<std::mutex> lock(commandMutex);
+        pendingCommands.swap(commands);
+    }
+    if (pendingCommands.empty()) return false;
+
+    for (auto& command : pendingCommands) {
+        command(engine);
+    }
+    pendingCommands.clear();
+    return true;
+}
+
+void SimulationThread::publish() {
+    PROFILE_ZONE("publish snapshot");
+    snapshots.getWriteBuffer().capture(engine, stepCount.load(std::memory_order_relaxed));
+    snapshots.publish();
+}
+
+const RenderSnapshot& SimulationThread::acquireSnapshot() {
+    snapshots.acquire();
+    return snapshots.getReadBuffer();
+}
+
+void SimulationThread::run() {
+    using Clock = std::chrono::steady_clock;
+    Profiler::setThreadName("simulation");
+    auto lastTime = Clock::now();
+
+    while (running.load(std::memory_order_relaxed)) {
+        bool changed = runCommands();
+
+        auto now = Clock::now();
+        float frameTime = std::chrono::duration<float>(now - lastTime).count();
+        lastTime = now;
+
+        int steps = engine.advance(frameTime);
+        stepCount.fetch_add(steps, std::memory_order_relaxed);
+        if (steps > 0 || changed) {
+            publish();
+        }
+
+        // 睡到下一步该执行的时候
+        float untilNextStep = (1.0f - engine.getInterpolationAlpha()) * engine.getFixedTimeStep();
+        std::this_thread::sleep_until(now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(untilNextStep)));
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <functional>
+#include <glm/glm.hpp>
+#include "PhysicsEngine.h"
+#include "TripleBuffer.h"
+
+// Immutable copy of what the renderer needs from one physics state
+struct RenderSnapshot {
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<glm::vec2> positions;
+    std::vector<glm::vec2> previousPositions;
+
+    // Shapes are only recopied when bodies were added or removed
+    std::vector<ShapeRef> shapes;
+    uint64_t bodyListVersion = ~0ull;
+    size_t vertexCount = 0;
+
+    // World-space vertices of the bodies that were deformed in the step, packed back to back;
+    // deformedOffsets[k] is where deformedBodies[k] starts
+    std::vector<uint32_t> deformedBodies;
+    std::vector<size_t> deformedOffsets;
+    std::vector<BodyVertex> deformedVertices;
+
+    uint64_t stepCount = 0;
+    float fixedTimeStep = 0.0f;
+    float alpha = 1.0f;             // engine interpolation alpha when published
+    Clock::time_point publishTime;
+
+    void capture(const PhysicsEngine& engine, uint64_t steps);
+
+    size_t getVertexCount() const { return vertexCount; }
+    // Interpolation alpha for a frame drawn at `now`, continuing from the publish time
+    float getAlphaAt(Clock::time_point now) const;
+    // Writes getVertexCount() world-space vertices, bodies placed at previous + alpha * (current - previous)
+    void copyVertices(BodyVertex* out, float renderAlpha) const;
+};
+
+// Runs a PhysicsEngine on its own thread at the engine's fixed time step and publishes a
+// RenderSnapshot after every batch of steps. While running, the engine belongs to this thread:
+// changes from other threads go through post().
+class SimulationThread {
+public:
+    explicit SimulationThread(PhysicsEngine& engine);
+    ~SimulationThread();
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void start();
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_relaxed); }
+
+    // Runs the command on the simulation thread before its next step (immediately when stopped)
+    void post(std::function<void(PhysicsEngine&)> command);
+
+    // Render thread: latest published snapshot; never blocks
+    const RenderSnapshot& acquireSnapshot();
+
+    uint64_t getStepCount() const { return stepCount.load(std::memory_order_relaxed); }
+
+private:
+    PhysicsEngine& engine;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> stepCount{0};
+
+    std::mutex commandMutex;
+    std::vector<std::function<void(PhysicsEngine&)>> commands;
+    std::vector<std::function<void(PhysicsEngine&)>> pendingCommands;
+
+    TripleBuffer<RenderSnapshot> snapshots;
+
+    void run();
+    bool runCommands();
+    void publish();
+};
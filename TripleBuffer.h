@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer / single-consumer triple buffer. The writer fills its back buffer and
+// publishes it by swapping it with the middle one; the reader swaps the middle buffer for its front
+// one when a newer one is there. Neither side ever waits, and the reader always gets the latest
+// complete buffer (intermediate ones are skipped).
+template<typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+    void publish() {
+        uint8_t previous = middle.exchange(static_cast<uint8_t>(writeIndex | freshBit), std::memory_order_acq_rel);
+        writeIndex = previous & indexMask;
+    }
+
+    // Reader side: switches to the newest published buffer; returns false if nothing new was published
+    bool acquire() {
+        if ((middle.load(std::memory_order_acquire) & freshBit) == 0) return false;
+        uint8_t previous = middle.exchange(readIndex, std::memory_order_acq_rel);
+        readIndex = previous & indexMask;
+        return true;
+    }
+    const T& getReadBuffer() const { return buffers[readIndex]; }
+
+private:
+    static constexpr uint8_t indexMask = 0x3;
+    static constexpr uint8_t freshBit = 0x4;
+
+    T buffers[3];
+    alignas(64) uint8_t writeIndex = 0;          // touched by the writer only
+    alignas(64) uint8_t readIndex = 1;           // touched by the reader only
+    alignas(64) std::atomic<uint8_t> middle{2};  // index of the shared buffer | freshBit
+};
@@ -0,0 +1,127 @@
+#include "VertexFormat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+struct PackedVertex {
+    glm::vec2 position;
+    uint32_t color;
+};
+
+struct CompactVertex {
+    uint32_t position;  // two 16-bit components, x in the low half
+    uint32_t color;
+};
+
+static_assert(sizeof(PackedVertex) == 12, "PackedVertex must match the vertex input stride");
+static_assert(sizeof(CompactVertex) == 8, "CompactVertex must match the vertex input stride");
+
+// 单精度转半精度，就近舍入到偶数；溢出为无穷，NaN 保持 NaN
+uint32_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    bits &= 0x7FFFFFFFu;
+
+    if (bits >= (143u << 23)) {
+        // 超出半精度范围（指数 >= 16）
+        return sign | (bits > (255u << 23) ? 0x7E00u : 0x7C00u);
+    }
+    if (bits < (113u << 23)) {
+        // 非规格化数：加一个魔数让 FPU 完成移位和舍入
+        const uint32_t magicBits = 126u << 23;
+        float magic;
+        std::memcpy(&magic, &magicBits, sizeof(magic));
+        float shifted;
+        std::memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += magic;
+        uint32_t result;
+        std::memcpy(&result, &shifted, sizeof(result));
+        return sign | (result - magicBits);
+    }
+    const uint32_t mantissaOdd = (bits >> 13) & 1u;
+    bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFu + mantissaOdd;
+    return sign | (bits >> 13);
+}
+
+uint32_t packHalf2(glm::vec2 v) {
+    return floatToHalf(v.x) | (floatToHalf(v.y) << 16);
+}
+
+// 与 packSnorm2x16 相同：截断到 [-1, 1]，乘 32767 后四舍五入
+uint32_t packSnorm2(glm::vec2 v) {
+    auto component = [](float x) {
+        float scaled = std::min(std::max(x, -1.0f), 1.0f) * 32767.0f;
+        return static_cast<uint32_t>(static_cast<uint16_t>(static_cast<int16_t>(scaled + std::copysign(0.5f, scaled))));
+    };
+    return component(v.x) | (component(v.y) << 16);
+}
+
+} // namespace
+
+const char* toString(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Float: return "float";
+    case VertexFormat::Packed: return "packed";
+    case VertexFormat::Half: return "half";
+    case VertexFormat::Snorm16: return "snorm16";
+    }
+    return "unknown";
+}
+
+size_t getVertexStride(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Float: return sizeof(BodyVertex);
+    case VertexFormat::Packed: return sizeof(PackedVertex);
+    case VertexFormat::Half:
+    case VertexFormat::Snorm16: return sizeof(CompactVertex);
+    }
+    return sizeof(BodyVertex);
+}
+
+float getPositionScale(VertexFormat format) {
+    return format == VertexFormat::Snorm16 ? snormPositionRange : 1.0f;
+}
+
+uint32_t packColor(const glm::vec3& color) {
+    // 与 packUnorm4x8 相同的舍入，但不经过 vec4 的通用实现
+    glm::uvec3 bytes(glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return bytes.r | (bytes.g << 8) | (bytes.b << 16) | 0xFF000000u;
+}
+
+void encodeVertices(VertexFormat format, const BodyVertex* vertices, size_t count, glm::vec2 offset, void* out) {
+    switch (format) {
+    case VertexFormat::Float: {
+        BodyVertex* target = static_cast<BodyVertex*>(out);
+        for (size_t v = 0; v < count; v++) {
+            target[v].position = vertices[v].position + offset;
+            target[v].color = vertices[v].color;
+        }
+        break;
+    }
+    case VertexFormat::Packed: {
+        PackedVertex* target = static_cast<PackedVertex*>(out);
+        for (size_t v = 0; v < count; v++) {
+            target[v] = {vertices[v].position + offset, packColor(vertices[v].color)};
+        }
+        break;
+    }
+    case VertexFormat::Half: {
+        CompactVertex* target = static_cast<CompactVertex*>(out);
+        for (size_t v = 0; v < count; v++) {
+            target[v] = {packHalf2(vertices[v].position + offset), packColor(vertices[v].color)};
+        }
+        break;
+    }
+    case VertexFormat::Snorm16: {
+        CompactVertex* target = static_cast<CompactVertex*>(out);
+        const float invRange = 1.0f / snormPositionRange;
+        for (size_t v = 0; v < count; v++) {
+            target[v] = {packSnorm2((vertices[v].position + offset) * invRange), packColor(vertices[v].color)};
+        }
+        break;
+    }
+    }
+}
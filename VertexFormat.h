@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "ShapeLibrary.h"
+
+// Layout of the vertices sent to the GPU. BodyVertex stays the CPU-side format; the compact
+// layouts pack the colour as RGBA8 unorm and optionally quantize positions to 16 bits.
+enum class VertexFormat {
+    Float,      // vec2 position, vec3 colour: 20 bytes
+    Packed,     // vec2 position, RGBA8 colour: 12 bytes
+    Half,       // half2 position, RGBA8 colour: 8 bytes
+    Snorm16     // snorm16x2 position / snormPositionRange, RGBA8 colour: 8 bytes
+};
+
+// Snorm16 positions cover [-snormPositionRange, snormPositionRange]; the vertex shader scales
+// them back through the instance scale. Vertices outside are clamped, which only happens far
+// off screen.
+constexpr float snormPositionRange = 2.0f;
+
+const char* toString(VertexFormat format);
+size_t getVertexStride(VertexFormat format);
+// Factor the vertex shader applies to decoded positions (the instance scale of a visible body)
+float getPositionScale(VertexFormat format);
+
+// RGBA8 unorm, red in the lowest byte, alpha 255
+uint32_t packColor(const glm::vec3& color);
+
+// Writes `count` vertices, each moved by `offset`, in the given layout (getVertexStride() bytes apart)
+void encodeVertices(VertexFormat format, const BodyVertex* vertices, size_t count, glm::vec2 offset, void* out);
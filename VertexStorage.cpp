@@ -0,0 +1,183 @@
+#include "VertexStorage.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+constexpr VkDeviceSize regionAlignment = 256;
+// 普通 BAR 窗口只有 256 MB，比它大的 DEVICE_LOCAL|HOST_VISIBLE 堆才当作可调整大小的 BAR
+constexpr VkDeviceSize barWindowSize = 256ull * 1024 * 1024;
+constexpr VkMemoryPropertyFlags hostMemory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+} // namespace
+
+void VertexStorage::init(VkPhysicalDevice physical, VkDevice logicalDevice, uint32_t framesInFlight, size_t size,
+                         size_t initialCount) {
+    physicalDevice = physical;
+    device = logicalDevice;
+    regionCount = framesInFlight;
+    elementSize = size;
+
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    directWrite = false;
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        const VkMemoryType& type = memProperties.memoryTypes[i];
+        if ((type.propertyFlags & (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | hostMemory)) ==
+                (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | hostMemory) &&
+            memProperties.memoryHeaps[type.heapIndex].size > barWindowSize) {
+            directWrite = true;
+            break;
+        }
+    }
+
+    allocate(std::max<size_t>(initialCount, 1));
+}
+
+void VertexStorage::destroy() {
+    for (auto& entry : retired) {
+        release(entry.allocation);
+    }
+    retired.clear();
+    release(deviceBuffer);
+    release(stagingBuffer);
+    capacity = 0;
+}
+
+void VertexStorage::beginFrame(uint32_t frameIndex) {
+    currentRegion = frameIndex;
+    frameNumber++;
+
+    // 这一帧的 fence 已经等过，更早 regionCount 帧以前的提交都已完成
+    auto done = [&](Retired& entry) {
+        if (entry.lastFrame + regionCount > frameNumber) return false;
+        release(entry.allocation);
+        return true;
+    };
+    retired.erase(std::remove_if(retired.begin(), retired.end(), done), retired.end());
+}
+
+bool VertexStorage::reserve(size_t count) {
+    if (count <= capacity) return false;
+
+    // 按倍数增长，场景逐渐变大时不会每帧都重新分配
+    retire(deviceBuffer);
+    retire(stagingBuffer);
+    allocate(std::max(count, capacity * 2));
+    return true;
+}
+
+char* VertexStorage::getWriteBase() const {
+    char* base = directWrite ? deviceBuffer.mapped : stagingBuffer.mapped;
+    return base + getRegionOffset();
+}
+
+void VertexStorage::recordUpload(VkCommandBuffer commandBuffer, size_t first, size_t count) const {
+    if (directWrite || first >= capacity || count == 0) return;
+
+    VkBufferCopy copyRegion = {};
+    copyRegion.srcOffset = getRegionOffset() + first * elementSize;
+    copyRegion.dstOffset = copyRegion.srcOffset;
+    copyRegion.size = std::min(count, capacity - first) * elementSize;
+    vkCmdCopyBuffer(commandBuffer, stagingBuffer.buffer, deviceBuffer.buffer, 1, &copyRegion);
+
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = deviceBuffer.buffer;
+    barrier.offset = copyRegion.dstOffset;
+    barrier.size = copyRegion.size;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0,
+                         0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void VertexStorage::allocate(size_t count) {
+    capacity = count;
+    regionSize = (capacity * elementSize + regionAlignment - 1) & ~(regionAlignment - 1);
+    VkDeviceSize totalSize = regionSize * regionCount;
+
+    if (directWrite) {
+        try {
+            deviceBuffer = createBuffer(totalSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | hostMemory, true);
+            return;
+        } catch (const std::runtime_error&) {
+            // 该内存类型不能用于顶点缓冲区，或者已经用完，退回暂存缓冲区
+            directWrite = false;
+        }
+    }
+    deviceBuffer = createBuffer(totalSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+    stagingBuffer = createBuffer(totalSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, hostMemory, true);
+}
+
+VertexStorage::Allocation VertexStorage::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage,
+                                                      VkMemoryPropertyFlags properties, bool map) {
+    Allocation allocation;
+
+    VkBufferCreateInfo bufferInfo = {};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &allocation.buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create vertex storage buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(device, allocation.buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    if (allocInfo.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device, &allocInfo, nullptr, &allocation.memory) != VK_SUCCESS) {
+        release(allocation);
+        throw std::runtime_error("failed to allocate vertex storage memory!");
+    }
+    vkBindBufferMemory(device, allocation.buffer, allocation.memory, 0);
+
+    if (map) {
+        void* data = nullptr;
+        if (vkMapMemory(device, allocation.memory, 0, size, 0, &data) != VK_SUCCESS) {
+            release(allocation);
+            throw std::runtime_error("failed to map vertex storage memory!");
+        }
+        allocation.mapped = static_cast<char*>(data);
+    }
+    return allocation;
+}
+
+void VertexStorage::retire(Allocation& allocation) {
+    if (allocation.buffer == VK_NULL_HANDLE) return;
+    retired.push_back({allocation, frameNumber});
+    allocation = Allocation();
+}
+
+void VertexStorage::release(Allocation& allocation) {
+    if (allocation.mapped) {
+        vkUnmapMemory(device, allocation.memory);
+    }
+    if (allocation.buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, allocation.buffer, nullptr);
+    }
+    if (allocation.memory != VK_NULL_HANDLE) {
+        vkFreeMemory(device, allocation.memory, nullptr);
+    }
+    allocation = Allocation();
+}
+
+uint32_t VertexStorage::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1u << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    return UINT32_MAX;
+}
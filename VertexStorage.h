@@ -0,0 +1,76 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+// Vertex input buffer of fixed-size elements (vertices or instances) in DEVICE_LOCAL memory, with
+// one region per frame in flight, grown geometrically as the scene grows. The CPU writes a frame's
+// elements into a persistently mapped staging region and the frame's command buffer copies them
+// into its device region. If the device exposes a memory type that is both DEVICE_LOCAL and
+// HOST_VISIBLE beyond the 256 MB BAR window (resizable BAR or unified memory), elements are written
+// to the device buffer directly and no copy is recorded.
+//
+// Growing replaces the buffers; the old ones are destroyed once every frame that may still read
+// them has completed.
+class VertexStorage {
+public:
+    void init(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t framesInFlight, size_t elementSize,
+              size_t initialCount);
+    void destroy();
+
+    // Call once per frame after the frame's fence wait: selects the frame's region and frees
+    // buffers no frame in flight can use any more
+    void beginFrame(uint32_t frameIndex);
+
+    // Makes every region hold at least `count` elements. Returns true if the buffers were
+    // replaced, in which case all region contents are lost.
+    bool reserve(size_t count);
+
+    // Host memory for this frame's elements; getCapacity() elements long
+    template <typename T>
+    T* getWriteRegion() const { return reinterpret_cast<T*>(getWriteBase()); }
+    size_t getCapacity() const { return capacity; }
+    bool usesDirectWrite() const { return directWrite; }
+
+    // Copies elements [first, first + count) of this frame's region to the device and makes them
+    // visible to vertex input. Must be recorded outside a render pass; does nothing with direct writes.
+    void recordUpload(VkCommandBuffer commandBuffer, size_t first, size_t count) const;
+
+    VkBuffer getBuffer() const { return deviceBuffer.buffer; }
+    VkDeviceSize getRegionOffset() const { return currentRegion * regionSize; }
+
+private:
+    struct Allocation {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        char* mapped = nullptr;
+    };
+
+    struct Retired {
+        Allocation allocation;
+        uint64_t lastFrame;   // last frame number that may have used it
+    };
+
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    uint32_t regionCount = 0;
+    bool directWrite = false;
+    size_t elementSize = 0;
+
+    size_t capacity = 0;            // elements per region
+    VkDeviceSize regionSize = 0;    // bytes per region
+    Allocation deviceBuffer;
+    Allocation stagingBuffer;       // unused with direct writes
+
+    uint32_t currentRegion = 0;
+    uint64_t frameNumber = 0;
+    std::vector<Retired> retired;
+
+    char* getWriteBase() const;
+    void allocate(size_t count);
+    Allocation createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, bool map);
+    void retire(Allocation& allocation);
+    void release(Allocation& allocation);
+    // UINT32_MAX if no memory type matches
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+};
@@ -0,0 +1,163 @@
+// Broadphase benchmark: all-pairs vs spatial hash on randomly scattered bodies, then
+// spatial hash vs incremental sweep-and-prune vs dynamic AABB tree on a scene that moves a
+// little every step.
+// Usage: BroadphaseBenchmark [bodyCount ...]   (defaults to 1000 10000 100000)
+#include "Broadphase.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Triangle-sized boxes at a constant density, so the average neighbour count
+// stays the same as the body count grows.
+vector<AABB> generateScene(size_t count, uint32_t seed) {
+    mt19937 rng(seed);
+    float worldSize = std::sqrt(static_cast<float>(count)) * 0.15f;
+    uniform_real_distribution<float> posDist(0.0f, worldSize);
+    uniform_real_distribution<float> sizeDist(0.05f, 0.2f);
+
+    vector<AABB> bounds(count);
+    for (auto& box : bounds) {
+        glm::vec2 pos(posDist(rng), posDist(rng));
+        glm::vec2 halfSize(sizeDist(rng) * 0.5f, sizeDist(rng) * 0.5f);
+        box = {pos - halfSize, pos + halfSize};
+    }
+    return bounds;
+}
+
+// Average milliseconds per computePairs call, repeated until at least minSeconds have passed
+double timeBroadphase(Broadphase& broadphase, const vector<AABB>& bounds, vector<BroadphasePair>& pairs, double minSeconds) {
+    using Clock = chrono::steady_clock;
+    int iterations = 0;
+    auto start = Clock::now();
+    double elapsed = 0.0;
+    do {
+        broadphase.computePairs(bounds, pairs);
+        iterations++;
+        elapsed = chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return elapsed * 1000.0 / iterations;
+}
+
+bool samePairs(const vector<BroadphasePair>& lhs, const vector<BroadphasePair>& rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    for (size_t i = 0; i < lhs.size(); i++) {
+        if (lhs[i].a != rhs[i].a || lhs[i].b != rhs[i].b) return false;
+    }
+    return true;
+}
+
+// Moves every body by a small random velocity per step and times both broadphases over the same frames
+bool runCoherentScene(size_t count, int steps) {
+    using Clock = chrono::steady_clock;
+    vector<AABB> bounds = generateScene(count, 99);
+    vector<glm::vec2> velocities(count);
+    mt19937 rng(7);
+    uniform_real_distribution<float> velDist(-0.002f, 0.002f);
+    for (auto& vel : velocities) {
+        vel = glm::vec2(velDist(rng), velDist(rng));
+    }
+
+    SpatialHashBroadphase spatialHash;
+    SweepAndPruneBroadphase sweepAndPrune;
+    DynamicTreeBroadphase dynamicTree;
+    vector<BroadphasePair> hashPairs;
+    vector<BroadphasePair> sapPairs;
+    vector<BroadphasePair> treePairs;
+
+    // First call builds the endpoint arrays / tree; not timed
+    sweepAndPrune.computePairs(bounds, sapPairs);
+    dynamicTree.computePairs(bounds, treePairs);
+
+    double hashSeconds = 0.0;
+    double sapSeconds = 0.0;
+    double treeSeconds = 0.0;
+    size_t swaps = 0;
+    size_t deltas = 0;
+    bool same = true;
+    for (int step = 0; step < steps; step++) {
+        for (size_t i = 0; i < count; i++) {
+            bounds[i].min += velocities[i];
+            bounds[i].max += velocities[i];
+        }
+
+        auto start = Clock::now();
+        spatialHash.computePairs(bounds, hashPairs);
+        auto middle = Clock::now();
+        sweepAndPrune.computePairs(bounds, sapPairs);
+        auto sapEnd = Clock::now();
+        dynamicTree.computePairs(bounds, treePairs);
+        auto end = Clock::now();
+
+        hashSeconds += chrono::duration<double>(middle - start).count();
+        sapSeconds += chrono::duration<double>(sapEnd - middle).count();
+        treeSeconds += chrono::duration<double>(end - sapEnd).count();
+        swaps += sweepAndPrune.getLastSwapCount();
+        deltas += sweepAndPrune.getAddedPairs().size() + sweepAndPrune.getRemovedPairs().size();
+        same = same && samePairs(hashPairs, sapPairs) && samePairs(hashPairs, treePairs);
+    }
+
+    cout << left << setw(10) << count
+         << setw(18) << fixed << setprecision(3) << hashSeconds * 1000.0 / steps
+         << setw(18) << sapSeconds * 1000.0 / steps
+         << setw(18) << treeSeconds * 1000.0 / steps
+         << setw(14) << swaps / steps
+         << deltas / steps
+         << (same ? "" : "  (PAIR MISMATCH)") << endl;
+    return same;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    vector<size_t> counts;
+    for (int i = 1; i < argc; i++) {
+        counts.push_back(static_cast<size_t>(strtoull(argv[i], nullptr, 10)));
+    }
+    if (counts.empty()) {
+        counts = {1000, 10000, 100000};
+    }
+
+    cout << left << setw(10) << "bodies" << setw(10) << "pairs"
+         << setw(16) << "all-pairs ms" << setw(18) << "spatial hash ms" << "speedup" << endl;
+
+    bool mismatch = false;
+    for (size_t count : counts) {
+        vector<AABB> bounds = generateScene(count, 1234);
+
+        BruteForceBroadphase bruteForce;
+        SpatialHashBroadphase spatialHash;
+        vector<BroadphasePair> brutePairs;
+        vector<BroadphasePair> hashPairs;
+
+        double bruteMs = timeBroadphase(bruteForce, bounds, brutePairs, 0.5);
+        double hashMs = timeBroadphase(spatialHash, bounds, hashPairs, 0.5);
+
+        // Both paths have to agree pair for pair
+        bool same = samePairs(brutePairs, hashPairs);
+        mismatch |= !same;
+
+        cout << left << setw(10) << count << setw(10) << hashPairs.size()
+             << setw(16) << fixed << setprecision(3) << bruteMs
+             << setw(18) << hashMs
+             << setprecision(1) << bruteMs / hashMs << "x"
+             << (same ? "" : "  (PAIR MISMATCH)") << endl;
+    }
+
+    cout << endl << "Coherent motion, 100 steps" << endl;
+    cout << left << setw(10) << "bodies" << setw(18) << "spatial hash ms" << setw(18) << "sweep&prune ms"
+         << setw(18) << "dynamic tree ms"
+         << setw(14) << "swaps/step" << "pair deltas/step" << endl;
+    for (size_t count : counts) {
+        mismatch |= !runCoherentScene(count, 100);
+    }
+
+    return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
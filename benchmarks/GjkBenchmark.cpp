@@ -0,0 +1,133 @@
+// GJK benchmark: slowly moving pairs of mixed convex shapes (circles, capsules, rounded boxes and
+// plain polygons) collided through collideConvex every frame, once with the simplex of each pair
+// kept from the previous frame and once starting cold. Reports the average GJK iterations and
+// the time per query of both, and checks that they find the same contacts.
+// Usage: GjkBenchmark [pairCount] [frames]   (defaults to 10000 pairs, 200 frames)
+#include "Narrowphase.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct Pair {
+    ShapeRef a;
+    ShapeRef b;
+    glm::vec2 offset;     // position of b relative to a
+    glm::vec2 velocity;   // per frame
+};
+
+ShapeRef randomShape(mt19937& rng) {
+    uniform_real_distribution<float> sizeDist(0.02f, 0.06f);
+    const glm::vec3 color(0.5f);
+    ShapeLibrary& library = ShapeLibrary::shared();
+    switch (rng() % 4) {
+    case 0:
+        return library.getCircle(sizeDist(rng), color);
+    case 1:
+        return library.getCapsule(sizeDist(rng), 0.5f * sizeDist(rng), color);
+    case 2:
+        return library.getRoundedBox(glm::vec2(sizeDist(rng), sizeDist(rng)), 0.01f, color);
+    default: {
+        float w = sizeDist(rng), h = sizeDist(rng);
+        return library.get({{{-w, -h}, color}, {{w, -h}, color}, {{0.0f, h}, color}});
+    }
+    }
+}
+
+// Pairs start around contact distance and drift a little each frame, so some touch and some do not
+vector<Pair> generatePairs(size_t count, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_real_distribution<float> angleDist(0.0f, 6.2831853f);
+    uniform_real_distribution<float> distanceDist(0.03f, 0.12f);
+    uniform_real_distribution<float> speedDist(0.0002f, 0.001f);
+
+    vector<Pair> pairs(count);
+    for (Pair& pair : pairs) {
+        pair.a = randomShape(rng);
+        pair.b = randomShape(rng);
+        float angle = angleDist(rng);
+        pair.offset = distanceDist(rng) * glm::vec2(cos(angle), sin(angle));
+        float heading = angleDist(rng);
+        pair.velocity = speedDist(rng) * glm::vec2(cos(heading), sin(heading));
+    }
+    return pairs;
+}
+
+struct RunResult {
+    double milliseconds;
+    uint64_t iterations;
+    uint64_t queries;
+    vector<ContactManifold> manifolds;   // last frame
+    vector<uint8_t> touching;
+};
+
+RunResult run(vector<Pair> pairs, int frames, bool warm) {
+    RunResult result = {0.0, 0, 0, vector<ContactManifold>(pairs.size()), vector<uint8_t>(pairs.size())};
+    vector<SimplexCache> caches(pairs.size());
+
+    for (int frame = 0; frame < frames; frame++) {
+        for (Pair& pair : pairs) {
+            pair.offset += pair.velocity;
+            // Kept within reach of each other: turn back when drifting too far
+            if (glm::length(pair.offset) > 0.15f) pair.velocity = -pair.velocity;
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < pairs.size(); i++) {
+            if (!warm) caches[i].count = 0;
+            uint32_t iterations = 0;
+            result.touching[i] = collideConvex(*pairs[i].a, glm::vec2(0.0f), *pairs[i].b, pairs[i].offset,
+                                               result.manifolds[i], caches[i], &iterations);
+            result.iterations += iterations;
+        }
+        result.milliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        result.queries += pairs.size();
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t pairCount = argc > 1 ? static_cast<size_t>(atoll(argv[1])) : 10000;
+    int frames = argc > 2 ? atoi(argv[2]) : 200;
+
+    const vector<Pair> pairs = generatePairs(pairCount, 1234);
+    cout << pairCount << " pairs, " << frames << " frames\n\n";
+
+    RunResult cold = run(pairs, frames, false);
+    RunResult warm = run(pairs, frames, true);
+
+    cout << left << setw(8) << "start" << right << setw(16) << "iterations/query" << setw(14) << "ns/query" << "\n";
+    for (const auto& [name, result] : {pair<const char*, const RunResult&>("cold", cold), {"warm", warm}}) {
+        cout << left << setw(8) << name << right << fixed << setprecision(3) << setw(16)
+             << static_cast<double>(result.iterations) / static_cast<double>(result.queries) << setprecision(1)
+             << setw(14) << result.milliseconds * 1.0e6 / static_cast<double>(result.queries) << "\n";
+    }
+
+    // The cached simplex only changes where GJK starts, the contacts must agree up to rounding
+    size_t touching = 0;
+    size_t mismatches = 0;
+    for (size_t i = 0; i < pairCount; i++) {
+        if (cold.touching[i] != warm.touching[i]) {
+            mismatches++;
+            continue;
+        }
+        if (!cold.touching[i]) continue;
+        touching++;
+        const ContactManifold& c = cold.manifolds[i];
+        const ContactManifold& w = warm.manifolds[i];
+        if (abs(c.points[0].depth - w.points[0].depth) > 1.0e-4f || glm::length(c.normal - w.normal) > 1.0e-3f) {
+            mismatches++;
+        }
+    }
+    cout << "\n" << touching << " pairs touching in the last frame, " << mismatches << " differ between cold and warm\n";
+    return mismatches == 0 ? 0 : 1;
+}
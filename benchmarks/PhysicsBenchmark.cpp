@@ -0,0 +1,419 @@
+// Microbenchmarks for the physics hot paths, over body counts from 10 to 1M and shape vertex
+// counts from 3 to 1024. Results are written as JSON so two builds can be compared.
+//
+// Usage:
+//   PhysicsBenchmark [--out results.json] [--filter text] [--max-bodies n] [--min-time ms] [--samples n]
+//   PhysicsBenchmark --compare baseline.json current.json [--threshold 0.10]
+//
+// Cases are named kernel/bodies[/vertices]. Every case runs --samples samples, each at least
+// --min-time long, and reports the median time per body (or per pair). --compare matches cases
+// by name and exits with 1 if any case got slower than the threshold allows.
+#include "PhysicsEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+const size_t bodyCounts[] = {10, 100, 1000, 10000, 100000, 1000000};
+const size_t vertexCounts[] = {3, 16, 64, 256, 1024};
+// Upper bound on bodies * vertices for the cases that touch every vertex
+const size_t maxVertexWork = 16u * 1024u * 1024u;
+
+// Results of pure kernels are stored here so the loops are not optimised away
+volatile size_t sink = 0;
+
+struct Options {
+    string outPath;
+    string filter;
+    size_t maxBodies = 1000000;
+    double minTimeMs = 100.0;
+    int samples = 5;
+    string comparePaths[2];
+    double threshold = 0.10;
+};
+
+struct Result {
+    string name;
+    size_t bodies = 0;
+    size_t vertices = 0;
+    size_t itemsPerRun = 0;   // bodies or pairs processed by one run of the kernel
+    uint64_t runsPerSample = 0;
+    double medianNs = 0.0;    // per item
+    double minNs = 0.0;
+};
+
+// Triangle fan around the origin cut to exactly `count` vertices (a triangle list, like every shape)
+ShapeRef makeShape(size_t count, float radius) {
+    vector<BodyVertex> vertices(count);
+    size_t triangles = (count + 2) / 3;
+    for (size_t v = 0; v < count; v++) {
+        size_t triangle = v / 3;
+        float angle = 6.2831853f * static_cast<float>(triangle + (v % 3 == 2 ? 1 : 0)) / static_cast<float>(triangles);
+        vertices[v].position = v % 3 == 0 ? glm::vec2(0.0f) : glm::vec2(cos(angle), sin(angle)) * radius;
+        vertices[v].color = glm::vec3(0.2f, 0.6f, 1.0f);
+    }
+    return ShapeLibrary::shared().get(vertices);
+}
+
+// Bodies scattered above the ground like the headless "rain" scene
+vector<BodyDesc> generateScene(size_t count, const ShapeRef& shape, uint32_t seed) {
+    mt19937 rng(seed);
+    float width = sqrt(static_cast<float>(count)) * 0.1f;
+    uniform_real_distribution<float> xDist(-width, width);
+    uniform_real_distribution<float> yDist(-0.5f, 2.0f);
+    uniform_real_distribution<float> velDist(-0.2f, 0.2f);
+
+    vector<BodyDesc> descs(count);
+    for (auto& desc : descs) {
+        desc.shape = shape;
+        desc.position = glm::vec2(xDist(rng), yDist(rng));
+        desc.velocity = glm::vec2(velDist(rng), velDist(rng));
+    }
+    return descs;
+}
+
+BodyStore makeStore(const vector<BodyDesc>& descs) {
+    BodyStore bodies;
+    for (const auto& desc : descs) {
+        uint32_t index = bodies.add(desc.shape, desc.mass);
+        bodies.teleport(index, desc.position);
+        bodies.velocities[index] = desc.velocity;
+        bodies.updateGeometry(index);
+    }
+    return bodies;
+}
+
+// Random pairs of overlapping neighbours, as the broadphase would report them
+vector<pair<uint32_t, uint32_t>> makePairs(size_t count, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_int_distribution<uint32_t> indexDist(0, static_cast<uint32_t>(count - 1));
+    vector<pair<uint32_t, uint32_t>> pairs(count);
+    for (auto& p : pairs) {
+        p.first = indexDist(rng);
+        do {
+            p.second = indexDist(rng);
+        } while (count > 1 && p.second == p.first);
+    }
+    return pairs;
+}
+
+// Runs `kernel` until a sample lasts at least minTime, then takes the median over the samples.
+// `setup`, when given, runs untimed before the warm-up and before every sample.
+Result measure(const string& name, size_t bodies, size_t vertices, size_t itemsPerRun, const Options& options,
+               const function<void()>& kernel, const function<void()>& setup = nullptr) {
+    Result result;
+    result.name = name;
+    result.bodies = bodies;
+    result.vertices = vertices;
+    result.itemsPerRun = itemsPerRun;
+
+    // One warm-up run, which also sizes the samples
+    if (setup) setup();
+    auto start = Clock::now();
+    kernel();
+    double once = chrono::duration<double, milli>(Clock::now() - start).count();
+    uint64_t runs = once > 0.0 ? max<uint64_t>(1, static_cast<uint64_t>(ceil(options.minTimeMs / once))) : 1000;
+
+    vector<double> samples;
+    for (int s = 0; s < options.samples; s++) {
+        if (setup) setup();
+        start = Clock::now();
+        for (uint64_t r = 0; r < runs; r++) {
+            kernel();
+        }
+        double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+        samples.push_back(ns / static_cast<double>(runs * max<size_t>(itemsPerRun, 1)));
+    }
+    sort(samples.begin(), samples.end());
+    result.runsPerSample = runs;
+    result.medianNs = samples[samples.size() / 2];
+    result.minNs = samples.front();
+    return result;
+}
+
+class Suite {
+public:
+    explicit Suite(const Options& opts) : options(opts) {}
+
+    bool wants(const string& name, size_t bodies) const {
+        return bodies <= options.maxBodies && (options.filter.empty() || name.find(options.filter) != string::npos);
+    }
+
+    void add(Result result) {
+        cout << left << setw(34) << result.name << right << fixed << setprecision(2) << setw(12) << result.medianNs
+             << " ns/item" << setw(12) << result.minNs << " min" << endl;
+        results.push_back(move(result));
+    }
+
+    const vector<Result>& getResults() const { return results; }
+
+private:
+    const Options& options;
+    vector<Result> results;
+};
+
+string caseName(const char* kernel, size_t bodies, size_t vertices = 0) {
+    string name = string(kernel) + "/" + to_string(bodies);
+    if (vertices > 0) name += "/" + to_string(vertices);
+    return name;
+}
+
+void runBodyKernels(Suite& suite, const Options& options) {
+    ShapeRef triangle = makeShape(3, 0.02f);
+    for (size_t count : bodyCounts) {
+        bool any = false;
+        for (const char* kernel : {"integrate", "updateGeometry", "checkCollision", "resolveCollision"}) {
+            any = any || suite.wants(caseName(kernel, count), count);
+        }
+        if (!any) continue;
+
+        vector<BodyDesc> scene = generateScene(count, triangle, 1);
+        BodyStore bodies = makeStore(scene);
+        vector<pair<uint32_t, uint32_t>> pairs = makePairs(count, 2);
+
+        string name = caseName("integrate", count);
+        if (suite.wants(name, count)) {
+            suite.add(measure(name, count, 3, count, options, [&]() {
+                for (uint32_t i = 0; i < bodies.size(); i++) {
+                    bodies.integrate(i, 0.016f);
+                }
+            }));
+        }
+        name = caseName("updateGeometry", count);
+        if (suite.wants(name, count)) {
+            suite.add(measure(name, count, 3, count, options, [&]() {
+                for (uint32_t i = 0; i < bodies.size(); i++) {
+                    bodies.updateGeometry(i);
+                }
+            }));
+        }
+        name = caseName("checkCollision", count);
+        if (suite.wants(name, count)) {
+            suite.add(measure(name, count, 3, pairs.size(), options, [&]() {
+                size_t hits = 0;
+                for (const auto& p : pairs) {
+                    hits += BodyStore::checkCollision(bodies, p.first, bodies, p.second);
+                }
+                sink = hits;
+            }));
+        }
+        name = caseName("resolveCollision", count);
+        if (suite.wants(name, count)) {
+            // Resolving separates the pair, so each run restarts from the generated state;
+            // the copy is included in the time
+            vector<glm::vec2> positions = bodies.positions;
+            vector<glm::vec2> velocities = bodies.velocities;
+            suite.add(measure(name, count, 3, pairs.size(), options, [&]() {
+                copy(positions.begin(), positions.end(), bodies.positions.begin());
+                copy(velocities.begin(), velocities.end(), bodies.velocities.begin());
+                for (const auto& p : pairs) {
+                    BodyStore::resolveCollision(bodies, p.first, bodies, p.second);
+                }
+            }));
+        }
+    }
+}
+
+void runVertexKernels(Suite& suite, const Options& options) {
+    for (size_t vertices : vertexCounts) {
+        ShapeRef shape = makeShape(vertices, 0.02f);
+        for (size_t count : bodyCounts) {
+            if (count * vertices > maxVertexWork) continue;
+
+            bool wantsDeform = suite.wants(caseName("deform", count, vertices), count);
+            bool wantsCopy = suite.wants(caseName("copyWorldVertices", count, vertices), count);
+            bool wantsStep = suite.wants(caseName("engineUpdate", count, vertices), count);
+            if (!wantsDeform && !wantsCopy && !wantsStep) continue;
+
+            vector<BodyDesc> scene = generateScene(count, shape, 3);
+            if (wantsDeform || wantsCopy) {
+                BodyStore bodies = makeStore(scene);
+                if (wantsDeform) {
+                    // updateGeometry drops the deformed copy, so every run pays for the copy-on-write
+                    suite.add(measure(caseName("deform", count, vertices), count, vertices, count, options, [&]() {
+                        for (uint32_t i = 0; i < bodies.size(); i++) {
+                            bodies.updateGeometry(i);
+                            bodies.deform(i, bodies.positions[i] + glm::vec2(0.01f, 0.0f), 1.0f);
+                        }
+                    }));
+                }
+                if (wantsCopy) {
+                    vector<BodyVertex> out(vertices);
+                    suite.add(measure(caseName("copyWorldVertices", count, vertices), count, vertices, count, options, [&]() {
+                        for (uint32_t i = 0; i < bodies.size(); i++) {
+                            bodies.copyWorldVertices(i, out.data(), 0.5f);
+                        }
+                    }));
+                }
+            }
+            if (wantsStep) {
+                // Stepping changes the scene (bodies fall, pile up and would fall asleep), so every
+                // sample rebuilds the engine from the generated scene and steps the same frames
+                unique_ptr<PhysicsEngine> engine;
+                suite.add(measure(caseName("engineUpdate", count, vertices), count, vertices, count, options, [&]() {
+                    engine->update(0.016f);
+                }, [&]() {
+                    engine = make_unique<PhysicsEngine>();
+                    engine->addBodies(scene.data(), scene.size());
+                }));
+            }
+        }
+    }
+}
+
+string jsonEscape(const string& text) {
+    string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+void writeJson(const string& path, const vector<Result>& results) {
+    ofstream file(path);
+    if (!file) {
+        throw runtime_error("failed to write " + path);
+    }
+#ifdef NDEBUG
+    const char* buildType = "release";
+#else
+    const char* buildType = "debug";
+#endif
+    file << "{\n"
+         << "  \"build\": {\"type\": \"" << buildType << "\", \"simd\": \"" << toString(detectSimdLevel())
+         << "\", \"threads\": " << JobSystem::getDefaultThreadCount() << "},\n"
+         << "  \"results\": [\n";
+    file << setprecision(6) << fixed;
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        file << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"bodies\": " << r.bodies << ", \"vertices\": " << r.vertices
+             << ", \"items\": " << r.itemsPerRun << ", \"runs\": " << r.runsPerSample << ", \"median_ns\": " << r.medianNs
+             << ", \"min_ns\": " << r.minNs << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+}
+
+// Reads name -> median_ns back from a file written by writeJson. Only understands that layout:
+// one result object per line.
+map<string, double> readJson(const string& path) {
+    ifstream file(path);
+    if (!file) {
+        throw runtime_error("failed to open " + path);
+    }
+    map<string, double> medians;
+    string line;
+    while (getline(file, line)) {
+        size_t nameKey = line.find("\"name\": \"");
+        size_t medianKey = line.find("\"median_ns\": ");
+        if (nameKey == string::npos || medianKey == string::npos) continue;
+
+        size_t nameStart = nameKey + 9;
+        size_t nameEnd = line.find('"', nameStart);
+        if (nameEnd == string::npos) {
+            throw runtime_error(path + ": malformed result line");
+        }
+        medians[line.substr(nameStart, nameEnd - nameStart)] = strtod(line.c_str() + medianKey + 13, nullptr);
+    }
+    if (medians.empty()) {
+        throw runtime_error(path + ": no results");
+    }
+    return medians;
+}
+
+int compare(const Options& options) {
+    map<string, double> baseline = readJson(options.comparePaths[0]);
+    map<string, double> current = readJson(options.comparePaths[1]);
+
+    cout << left << setw(34) << "case" << right << setw(14) << "baseline ns" << setw(14) << "current ns" << setw(10)
+         << "change" << "\n";
+    int regressions = 0;
+    int improvements = 0;
+    for (const auto& entry : baseline) {
+        auto found = current.find(entry.first);
+        if (found == current.end()) continue;
+
+        double change = entry.second > 0.0 ? found->second / entry.second - 1.0 : 0.0;
+        const char* verdict = "";
+        if (change > options.threshold) {
+            verdict = "  REGRESSION";
+            regressions++;
+        } else if (change < -options.threshold) {
+            verdict = "  faster";
+            improvements++;
+        }
+        cout << left << setw(34) << entry.first << right << fixed << setprecision(2) << setw(14) << entry.second
+             << setw(14) << found->second << setprecision(1) << setw(9) << change * 100.0 << "%" << verdict << "\n";
+    }
+    for (const auto& entry : current) {
+        if (!baseline.count(entry.first)) cout << entry.first << ": new case\n";
+    }
+    for (const auto& entry : baseline) {
+        if (!current.count(entry.first)) cout << entry.first << ": missing from current run\n";
+    }
+
+    cout << "\n" << regressions << " regressions, " << improvements << " improvements beyond "
+         << setprecision(0) << options.threshold * 100.0 << "%\n";
+    return regressions > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        auto value = [&]() -> string {
+            if (i + 1 >= argc) throw runtime_error("missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "--out") options.outPath = value();
+        else if (arg == "--filter") options.filter = value();
+        else if (arg == "--max-bodies") options.maxBodies = static_cast<size_t>(stoull(value()));
+        else if (arg == "--min-time") options.minTimeMs = stod(value());
+        else if (arg == "--samples") options.samples = max(1, stoi(value()));
+        else if (arg == "--threshold") options.threshold = stod(value());
+        else if (arg == "--compare") {
+            options.comparePaths[0] = value();
+            options.comparePaths[1] = value();
+        } else throw runtime_error("unknown option " + arg);
+    }
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+        if (!options.comparePaths[0].empty()) {
+            return compare(options);
+        }
+
+        Suite suite(options);
+        runBodyKernels(suite, options);
+        runVertexKernels(suite, options);
+        if (!options.outPath.empty()) {
+            writeJson(options.outPath, suite.getResults());
+            cout << "\nwrote " << suite.getResults().size() << " results to " << options.outPath << "\n";
+        }
+    } catch (const exception& e) {
+        cerr << "error: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+// Thread scaling benchmark: times PhysicsEngine::update on the same scene with 1, 2, 4, 8 and 16
+// threads and checks that every run ends in exactly the same state as the single-threaded one.
+// At each thread count it also runs a fan-out/fan-in task graph and a cyclic one through the job
+// system directly, checking the dependency order and that the cycle is rejected.
+// Usage: ScalingBenchmark [bodyCount] [steps]   (defaults to 20000 bodies, 120 steps)
+#include "PhysicsEngine.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+// Small triangles scattered over a wide area above the ground, so they fall and pile up
+vector<BodyDesc> generateScene(size_t count, uint32_t seed) {
+    mt19937 rng(seed);
+    float width = std::sqrt(static_cast<float>(count)) * 0.1f;
+    uniform_real_distribution<float> xDist(-width, width);
+    uniform_real_distribution<float> yDist(-0.5f, 2.0f);
+    uniform_real_distribution<float> sizeDist(0.01f, 0.03f);
+    uniform_real_distribution<float> velDist(-0.2f, 0.2f);
+
+    vector<BodyDesc> descs(count);
+    for (auto& desc : descs) {
+        float size = sizeDist(rng);
+        glm::vec3 color(0.2f, 0.6f, 1.0f);
+        desc.vertices = {
+            {{0.0f, size}, color},
+            {{-size, -size}, color},
+            {{size, -size}, color},
+        };
+        desc.position = glm::vec2(xDist(rng), yDist(rng));
+        desc.velocity = glm::vec2(velDist(rng), velDist(rng));
+    }
+    return descs;
+}
+
+// FNV-1a over the raw bits of every position and velocity
+uint64_t hashState(const BodyStore& bodies) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    mix(bodies.positions.data(), bodies.positions.size() * sizeof(glm::vec2));
+    mix(bodies.velocities.data(), bodies.velocities.size() * sizeof(glm::vec2));
+    return hash;
+}
+
+// Layers of tasks where every task of a layer depends on every task of the layer before; each task
+// checks that all of its dependencies have already finished. Then a two-task cycle must throw.
+bool checkTaskGraph(JobSystem& jobs) {
+    const uint32_t layers = 4;
+    const uint32_t width = 16;
+    vector<atomic<int>> finished(layers * width);
+    atomic<bool> ordered{true};
+
+    TaskGraph graph;
+    for (uint32_t layer = 0; layer < layers; layer++) {
+        for (uint32_t i = 0; i < width; i++) {
+            uint32_t task = graph.addTask([&, layer, i]() {
+                // In the current run every dependency has finished once more than this task
+                int runs = finished[layer * width + i].load();
+                for (uint32_t before = 0; layer > 0 && before < width; before++) {
+                    if (finished[(layer - 1) * width + before].load() != runs + 1) ordered = false;
+                }
+                finished[layer * width + i]++;
+            });
+            for (uint32_t before = 0; layer > 0 && before < width; before++) {
+                graph.addDependency(task, (layer - 1) * width + before);
+            }
+        }
+    }
+
+    // The same graph runs twice, like the engine's step graph
+    for (int run = 0; run < 2; run++) {
+        jobs.run(graph);
+    }
+    bool ranTwice = true;
+    for (auto& count : finished) ranTwice = ranTwice && count.load() == 2;
+
+    TaskGraph cycle;
+    TaskGraph::TaskId first = cycle.addTask([]() {});
+    TaskGraph::TaskId second = cycle.addTask([]() {});
+    cycle.addDependency(first, second);
+    cycle.addDependency(second, first);
+    bool rejected = false;
+    try {
+        jobs.run(cycle);
+    } catch (const runtime_error&) {
+        rejected = true;
+    }
+    return ordered && ranTwice && rejected;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t bodyCount = argc > 1 ? static_cast<size_t>(atoll(argv[1])) : 20000;
+    int steps = argc > 2 ? atoi(argv[2]) : 120;
+    const float deltaTime = 0.016f;
+    const unsigned threadCounts[] = {1, 2, 4, 8, 16};
+
+    vector<BodyDesc> scene = generateScene(bodyCount, 42);
+    cout << bodyCount << " bodies, " << steps << " steps, "
+         << JobSystem::getDefaultThreadCount() << " hardware threads\n\n";
+    cout << left << setw(10) << "threads" << right << setw(14) << "ms/step" << setw(12) << "speedup" << "  state  graph\n";
+
+    double baseline = 0.0;
+    uint64_t referenceHash = 0;
+    bool allMatch = true;
+    bool allGraphsOk = true;
+    for (unsigned threads : threadCounts) {
+        PhysicsEngine engine;
+        engine.setThreadCount(threads);
+        engine.addBodies(scene.data(), scene.size());
+
+        // A few untimed steps so the broadphase buffers and worker threads are warm
+        for (int i = 0; i < 5; i++) {
+            engine.update(deltaTime);
+        }
+
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < steps; i++) {
+            engine.update(deltaTime);
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / steps;
+
+        uint64_t hash = hashState(engine.getBodies());
+        if (threads == 1) {
+            baseline = ms;
+            referenceHash = hash;
+        }
+        bool match = hash == referenceHash;
+        allMatch = allMatch && match;
+        bool graphOk = checkTaskGraph(engine.getJobSystem());
+        allGraphsOk = allGraphsOk && graphOk;
+
+        cout << left << setw(10) << threads << right << fixed << setprecision(3) << setw(14) << ms
+             << setprecision(2) << setw(11) << baseline / ms << "x" << "  " << left << setw(7)
+             << (match ? "ok" : "MISMATCH") << (graphOk ? "ok" : "FAILED") << right << "\n";
+    }
+
+    if (!allMatch) {
+        cout << "\nMulti-threaded runs diverged from the single-threaded result\n";
+        return EXIT_FAILURE;
+    }
+    if (!allGraphsOk) {
+        cout << "\nA task graph ran out of dependency order or accepted a cycle\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
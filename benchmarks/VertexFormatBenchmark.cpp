@@ -0,0 +1,73 @@
+// Vertex format benchmark: encodes the same world-space vertices in every GPU vertex layout and
+// reports the bytes written per frame, the bandwidth at 60 frames per second, how much each
+// compact layout saves against the float layout, and the CPU time of the encode.
+// Usage: VertexFormatBenchmark [vertexCount] [frames]   (defaults to 100000 vertices, 200 frames)
+#include "VertexFormat.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Triangles of a few sizes scattered over the visible area, one colour per triangle like the scenes
+vector<BodyVertex> generateVertices(size_t count, uint32_t seed) {
+    mt19937 rng(seed);
+    uniform_real_distribution<float> posDist(-1.0f, 1.0f);
+    uniform_real_distribution<float> unitDist(0.0f, 1.0f);
+
+    vector<BodyVertex> vertices(count);
+    for (size_t v = 0; v < count; v += 3) {
+        glm::vec2 center(posDist(rng), posDist(rng));
+        glm::vec3 color(unitDist(rng), unitDist(rng), unitDist(rng));
+        float size = 0.01f + 0.02f * unitDist(rng);
+        const glm::vec2 corners[] = {{0.0f, size}, {-size, -size}, {size, -size}};
+        for (size_t c = 0; c < 3 && v + c < count; c++) {
+            vertices[v + c] = {center + corners[c], color};
+        }
+    }
+    return vertices;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t vertexCount = argc > 1 ? static_cast<size_t>(atoll(argv[1])) : 100000;
+    int frames = argc > 2 ? atoi(argv[2]) : 200;
+    const double framesPerSecond = 60.0;
+
+    const vector<BodyVertex> vertices = generateVertices(vertexCount, 1234);
+    // Destination as large as the float layout needs, reused like a mapped upload region
+    vector<char> region(vertexCount * getVertexStride(VertexFormat::Float));
+    const double floatBytes = static_cast<double>(vertexCount * getVertexStride(VertexFormat::Float));
+
+    cout << vertexCount << " vertices, " << frames << " frames, bandwidth at " << framesPerSecond << " fps\n\n";
+    cout << left << setw(10) << "format" << right << setw(8) << "stride" << setw(12) << "KB/frame" << setw(10) << "MB/s"
+         << setw(12) << "saved KB" << setw(9) << "saved" << setw(12) << "ms/frame" << "\n";
+
+    volatile char sink = 0;
+    for (VertexFormat format : {VertexFormat::Float, VertexFormat::Packed, VertexFormat::Half, VertexFormat::Snorm16}) {
+        size_t stride = getVertexStride(format);
+        double bytes = static_cast<double>(vertexCount * stride);
+
+        auto start = chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            // Moves every frame, so the encode cannot be hoisted out of the loop
+            glm::vec2 offset(0.0f, 1.0e-4f * static_cast<float>(frame % 16));
+            encodeVertices(format, vertices.data(), vertices.size(), offset, region.data());
+            sink = sink + region[static_cast<size_t>(frame) % region.size()];
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / frames;
+
+        cout << left << setw(10) << toString(format) << right << setw(8) << stride << fixed << setprecision(1)
+             << setw(12) << bytes / 1024.0 << setw(10) << bytes * framesPerSecond / (1024.0 * 1024.0)
+             << setw(12) << (floatBytes - bytes) / 1024.0 << setw(8) << (1.0 - bytes / floatBytes) * 100.0 << "%"
+             << setprecision(3) << setw(12) << ms << "\n";
+    }
+
+    return EXIT_SUCCESS;
+}
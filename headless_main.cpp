@@ -0,0 +1,182 @@
+// Headless simulation driver: runs the physics engine with no window or GPU.
+// Loads a scene file or generates one, runs a fixed number of steps as fast as possible and
+// prints throughput and per-phase timings.
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include "PhysicsEngine.h"
+#include "Profiler.h"
+#include "Scene.h"
+
+using namespace std;
+
+namespace {
+
+struct Options {
+    string scenePath;
+    string generate = "rain";
+    size_t bodyCount = 10000;
+    int steps = 600;
+    float deltaTime = 1.0f / 60.0f;
+    unsigned threads = 0;
+    string broadphase = "hash";
+    string simd;
+    bool sleeping = true;
+    uint32_t seed = 1;
+    string savePath;
+    string tracePath;
+};
+
+void printUsage() {
+    cout << "Usage: PhysicsHeadless [options]\n"
+         << "  --scene <file>         load a scene file\n"
+         << "  --generate <kind>      generate a scene: rain, pile, grid or round (default rain)\n"
+         << "  --bodies <n>           bodies in a generated scene (default 10000)\n"
+         << "  --seed <n>             random seed for generated scenes (default 1)\n"
+         << "  --save <file>          write the scene to a file before running\n"
+         << "  --steps <n>            steps to run (default 600)\n"
+         << "  --dt <seconds>         time step (default 1/60)\n"
+         << "  --threads <n>          worker threads including the main one (default: all cores)\n"
+         << "  --broadphase <type>    brute, hash, sap or tree (default hash)\n"
+         << "  --simd <level>         scalar, sse4 or avx2 (default: best supported)\n"
+         << "  --sleep <on|off>       put bodies at rest to sleep (default on)\n"
+         << "  --trace <file>         profile the run and write a Chrome trace\n";
+}
+
+bool parseSwitch(const string& option, const string& value) {
+    if (value == "on") return true;
+    if (value == "off") return false;
+    throw runtime_error("expected on or off for " + option);
+}
+
+Options parseOptions(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            exit(EXIT_SUCCESS);
+        }
+        if (i + 1 >= argc) {
+            throw runtime_error("missing value for " + arg);
+        }
+        string value = argv[++i];
+        if (arg == "--scene") options.scenePath = value;
+        else if (arg == "--generate") options.generate = value;
+        else if (arg == "--bodies") options.bodyCount = static_cast<size_t>(stoull(value));
+        else if (arg == "--seed") options.seed = static_cast<uint32_t>(stoul(value));
+        else if (arg == "--save") options.savePath = value;
+        else if (arg == "--steps") options.steps = stoi(value);
+        else if (arg == "--dt") options.deltaTime = stof(value);
+        else if (arg == "--threads") options.threads = static_cast<unsigned>(stoul(value));
+        else if (arg == "--broadphase") options.broadphase = value;
+        else if (arg == "--simd") options.simd = value;
+        else if (arg == "--sleep") options.sleeping = parseSwitch(arg, value);
+        else if (arg == "--trace") options.tracePath = value;
+        else throw runtime_error("unknown option " + arg);
+    }
+    return options;
+}
+
+BroadphaseType parseBroadphase(const string& name) {
+    if (name == "brute") return BroadphaseType::BruteForce;
+    if (name == "hash") return BroadphaseType::SpatialHash;
+    if (name == "sap") return BroadphaseType::SweepAndPrune;
+    if (name == "tree") return BroadphaseType::DynamicTree;
+    throw runtime_error("unknown broadphase " + name);
+}
+
+SimdLevel parseSimdLevel(const string& name) {
+    if (name == "scalar") return SimdLevel::Scalar;
+    if (name == "sse4") return SimdLevel::SSE4;
+    if (name == "avx2") return SimdLevel::AVX2;
+    throw runtime_error("unknown SIMD level " + name);
+}
+
+// FNV-1a over positions and velocities, to compare runs
+uint64_t hashState(const BodyStore& bodies) {
+    uint64_t hash = 1469598103934665603ull;
+    auto mix = [&](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+    };
+    mix(bodies.positions.data(), bodies.positions.size() * sizeof(glm::vec2));
+    mix(bodies.velocities.data(), bodies.velocities.size() * sizeof(glm::vec2));
+    return hash;
+}
+
+void printPhase(const char* name, double totalMs, double stepMs, int steps) {
+    cout << "  " << left << setw(14) << name << right << fixed << setprecision(3) << setw(10) << totalMs / steps << " ms"
+         << setprecision(1) << setw(8) << (stepMs > 0.0 ? totalMs / stepMs * 100.0 : 0.0) << " %\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+
+        Scene scene = options.scenePath.empty() ? Scene::generate(options.generate, options.bodyCount, options.seed)
+                                                : Scene::load(options.scenePath);
+        if (!options.savePath.empty()) {
+            scene.save(options.savePath);
+        }
+
+        PhysicsEngine engine;
+        if (options.threads > 0) engine.setThreadCount(options.threads);
+        engine.setBroadphase(parseBroadphase(options.broadphase));
+        if (!options.simd.empty()) engine.setSimdLevel(parseSimdLevel(options.simd));
+        engine.setSleepingEnabled(options.sleeping);
+        scene.applyTo(engine);
+
+        cout << (options.scenePath.empty() ? "scene " + options.generate : options.scenePath) << ": "
+             << engine.getObjectCount() << " bodies, " << options.steps << " steps of " << options.deltaTime << " s, "
+             << engine.getThreadCount() << " threads, " << options.broadphase << " broadphase, "
+             << toString(engine.getSimdLevel()) << " integrator\n";
+
+        if (!options.tracePath.empty()) {
+            Profiler::setThreadName("main");
+            Profiler::setEnabled(true);
+        }
+
+        StepTimings totals;
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < options.steps; i++) {
+            engine.update(options.deltaTime);
+            const StepTimings& step = engine.getLastStepTimings();
+            totals.integrate += step.integrate;
+            totals.broadphase += step.broadphase;
+            totals.narrowphase += step.narrowphase;
+            totals.response += step.response;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        double stepsPerSecond = seconds > 0.0 ? options.steps / seconds : 0.0;
+        cout << fixed << setprecision(1)
+             << "\n" << stepsPerSecond << " steps/s, " << stepsPerSecond * engine.getObjectCount() << " bodies/s, "
+             << setprecision(3) << seconds * 1000.0 / options.steps << " ms/step\n\n"
+             << "per step:\n";
+        double totalMs = totals.total();
+        printPhase("integrate", totals.integrate, totalMs, options.steps);
+        printPhase("broadphase", totals.broadphase, totalMs, options.steps);
+        printPhase("narrowphase", totals.narrowphase, totalMs, options.steps);
+        printPhase("response", totals.response, totalMs, options.steps);
+        cout << "\n" << engine.getAwakeCount() << " awake, " << engine.getSleepingIslandCount() << " sleeping islands\n";
+        cout << "state hash " << hex << hashState(engine.getBodies()) << dec << "\n";
+
+        if (!options.tracePath.empty()) {
+            Profiler::writeChromeTrace(options.tracePath);
+            cout << "trace written to " << options.tracePath << "\n";
+        }
+    } catch (const exception& e) {
+        cerr << "error: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -14,6 +14,12 @@
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 #include "PhysicsEngine.h"
+#include "SimulationThread.h"
+#include "InstanceBatcher.h"
+#include "VertexFormat.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "VertexStorage.h"
 
 using namespace std;
 
@@ -84,7 +90,6 @@ VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>
 VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 VkShaderModule createShaderModule(const std::vector<char>& code);
-uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 bool checkValidationLayerSupport();
 
 
@@ -177,8 +182,6 @@ VkPipeline graphicsPipeline;
 std::vector<VkFramebuffer> swapchainFramebuffers;
 VkCommandPool commandPool;
 std::vector<VkCommandBuffer> commandBuffers;
-VkBuffer vertexBuffer;
-VkDeviceMemory vertexBufferMemory;
 std::vector<VkSemaphore> imageAvailableSemaphores;
 std::vector<VkSemaphore> renderFinishedSemaphores;
 std::vector<VkFence> inFlightFences;
@@ -186,10 +189,42 @@ std::vector<VkFence> imagesInFlight;
 size_t currentFrame = 0;
 const int MAX_FRAMES_IN_FLIGHT = 3;
 
+// Vertex buffers: one device-local region per frame in flight, grown with the scene. A frame writes
+// only its own regions, which the GPU finished reading when the frame's fence was signalled.
+VertexStorage vertexStorage;                         // shape meshes, then this frame's deformed vertices
+VertexStorage instanceStorage;                       // one BodyInstance per body
+std::vector<uint64_t> regionMeshVersions;            // mesh version held by each frame's vertex region
+VertexFormat vertexFormat = VertexFormat::Packed;    // --vertex-format float|packed|half|snorm16
+
 // 物理引擎相关
 std::unique_ptr<PhysicsEngine> physicsEngine;
-std::vector<std::shared_ptr<PhysicsObject>> physicsObjects;
-auto lastFrameTime = std::chrono::high_resolution_clock::now();
+std::unique_ptr<SimulationThread> simulationThread; // steps physicsEngine; rendering reads its snapshots
+size_t vertexUploadBegin = 0;                        // vertices [begin, end) written by the last updateVertexBufferData
+size_t vertexUploadEnd = 0;
+size_t instanceUploadBegin = 0;                      // instances [begin, end) rewritten by the last updateVertexBufferData
+size_t instanceUploadEnd = 0;
+size_t uploadedInstanceCount = 0;                    // instances drawn from the current region
+std::unique_ptr<JobSystem> renderJobs;               // render thread's own workers for the instance writes
+std::unique_ptr<InstanceBatcher> instanceBatcher;
+
+// Profiling: enabled by --trace <file>; F12 writes the trace on demand, exit writes it again
+std::string tracePath;
+GpuProfiler gpuProfiler;                             // render pass timestamps, merged into the same trace
+
+VertexFormat parseVertexFormat(const std::string& name) {
+    for (VertexFormat format : {VertexFormat::Float, VertexFormat::Packed, VertexFormat::Half, VertexFormat::Snorm16}) {
+        if (name == toString(format)) return format;
+    }
+    throw std::runtime_error("unknown vertex format " + name);
+}
+
+VkFormat getPositionFormat(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Half: return VK_FORMAT_R16G16_SFLOAT;
+    case VertexFormat::Snorm16: return VK_FORMAT_R16G16_SNORM;
+    default: return VK_FORMAT_R32G32_SFLOAT;
+    }
+}
 
 VkShaderModule createShaderModule(const std::vector<char>& code) {
     VkShaderModuleCreateInfo createInfo = {};
@@ -242,7 +277,7 @@ void initPhysicsObjects() {
         
         cout << "Created " << triangleVertices.size() << " triangle vertex sets" << endl;
         
-        // Create physics objects
+        // Create physics objects (the engine keeps them; no separate list needed)
         for (size_t i = 0; i < triangleVertices.size(); i++) {
             cout << "Creating physics object " << i << "..." << endl;
             auto obj = std::make_shared<PhysicsObject>(triangleVertices[i], 1.0f + i * 0.5f);
@@ -251,41 +286,69 @@ void initPhysicsObjects() {
             obj->setElasticity(0.7f + i * 0.1f);
             obj->setFriction(0.1f + i * 0.05f);
             
-            physicsObjects.push_back(obj);
             physicsEngine->addObject(obj);
             cout << "Physics object " << i << " created and added" << endl;
         }
         
-        cout << "Created " << physicsObjects.size() << " physics objects" << endl;
+        cout << "Created " << physicsEngine->getObjectCount() << " physics objects" << endl;
+        
+        simulationThread = std::make_unique<SimulationThread>(*physicsEngine);
+        renderJobs = std::make_unique<JobSystem>(std::max(1u, JobSystem::getDefaultThreadCount() / 2));
+        instanceBatcher = std::make_unique<InstanceBatcher>(*renderJobs, MAX_FRAMES_IN_FLIGHT, vertexFormat);
     } catch (const std::exception& e) {
         cout << "Error initializing physics objects: " << e.what() << endl;
     }
 }
 
 void updateVertexBufferData() {
-    if (!physicsEngine || physicsObjects.empty()) {
+    PROFILE_ZONE("updateVertexBufferData");
+    vertexUploadBegin = 0;
+    vertexUploadEnd = 0;
+    instanceUploadBegin = 0;
+    instanceUploadEnd = 0;
+    uploadedInstanceCount = 0;
+    vertexStorage.beginFrame(static_cast<uint32_t>(currentFrame));
+    instanceStorage.beginFrame(static_cast<uint32_t>(currentFrame));
+    if (!simulationThread) {
         return;
     }
     
-    // Collect vertex data from all physics objects
-    std::vector<PhysicsObject::Vertex> allVertices;
-    
-    for (const auto& obj : physicsObjects) {
-        const auto& vertices = obj->getVertices();
-        allVertices.insert(allVertices.end(), vertices.begin(), vertices.end());
-    }
-    
-    if (allVertices.empty()) {
+    // Latest state published by the simulation thread; never waits for a step
+    const RenderSnapshot& snapshot = simulationThread->acquireSnapshot();
+    if (snapshot.getVertexCount() == 0) {
         return;
     }
     
-    // Update vertex buffer
-    VkDeviceSize bufferSize = allVertices.size() * sizeof(PhysicsObject::Vertex);
+    // Draw bodies between the last two physics states: one instance per body, shape meshes written
+    // only when the set of shapes changed, deformed bodies' vertices after the meshes
+    float alpha = snapshot.getAlphaAt(RenderSnapshot::Clock::now());
+    instanceBatcher->update(snapshot);
+    const size_t meshVertexCount = instanceBatcher->getMeshVertexCount();
+    if (vertexStorage.reserve(meshVertexCount + instanceBatcher->getDeformedVertexCount())) {
+        // New buffers start empty, so every region needs the meshes again
+        std::fill(regionMeshVersions.begin(), regionMeshVersions.end(), ~0ull);
+    }
+    if (instanceStorage.reserve(instanceBatcher->getInstanceCount())) {
+        instanceBatcher->invalidate();
+    }
     
-    void* data;
-    vkMapMemory(device, vertexBufferMemory, 0, bufferSize, 0, &data);
-    memcpy(data, allVertices.data(), (size_t)bufferSize);
-    vkUnmapMemory(device, vertexBufferMemory);
+    char* vertices = vertexStorage.getWriteRegion<char>();
+    const std::vector<uint8_t>& meshData = instanceBatcher->getMeshData();
+    vertexUploadBegin = meshVertexCount;
+    if (regionMeshVersions[currentFrame] != instanceBatcher->getMeshVersion()) {
+        std::copy(meshData.begin(), meshData.end(), vertices);
+        regionMeshVersions[currentFrame] = instanceBatcher->getMeshVersion();
+        vertexUploadBegin = 0;
+    }
+    instanceBatcher->writeDeformedVertices(snapshot, alpha, vertices + meshData.size());
+    vertexUploadEnd = meshVertexCount + instanceBatcher->getDeformedVertexCount();
+    
+    // Only instances that moved since this region was last written are rewritten and uploaded
+    InstanceRange instances = instanceBatcher->writeInstances(snapshot, alpha, static_cast<uint32_t>(currentFrame),
+                                                              instanceStorage.getWriteRegion<BodyInstance>());
+    instanceUploadBegin = instances.first;
+    instanceUploadEnd = instances.end;
+    uploadedInstanceCount = instanceBatcher->getInstanceCount();
 }
 
 void initVulkan() {
@@ -328,6 +391,12 @@ void initVulkan() {
     // Step 12: Create Synchronization Objects (semaphores and fences)
     createSyncObjects();
     
+    // Step 13: GPU timestamp queries (skipped if the graphics queue has no timestamps)
+    if (!gpuProfiler.init(physicalDevice, device, findQueueFamilies(physicalDevice).graphicsFamily, graphicsQueue,
+                          commandPool, MAX_FRAMES_IN_FLIGHT)) {
+        cout << "GPU timestamps not supported by the graphics queue" << endl;
+    }
+    
     // Initialize physics objects
     initPhysicsObjects();
     
@@ -736,30 +805,48 @@ void createGraphicsPipeline() {
     
     VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
     
-    // Vertex input state
-    VkVertexInputBindingDescription bindingDescription = {};
-    bindingDescription.binding = 0;
-    bindingDescription.stride = sizeof(PhysicsObject::Vertex);
-    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    // Vertex input state: binding 0 steps through a shape's mesh, binding 1 once per body
+    std::array<VkVertexInputBindingDescription, 2> bindingDescriptions = {};
+    bindingDescriptions[0].binding = 0;
+    bindingDescriptions[0].stride = static_cast<uint32_t>(getVertexStride(vertexFormat));
+    bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    bindingDescriptions[1].binding = 1;
+    bindingDescriptions[1].stride = sizeof(BodyInstance);
+    bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 
-    std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions = {};
+    std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions = {};
     
     // Position attribute
     attributeDescriptions[0].binding = 0;
     attributeDescriptions[0].location = 0;
-    attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-    attributeDescriptions[0].offset = offsetof(PhysicsObject::Vertex, position);
+    attributeDescriptions[0].format = getPositionFormat(vertexFormat);
+    attributeDescriptions[0].offset = 0;
     
-    // Color attribute
+    // Color attribute; an RGBA8 colour feeds the vec3 input, alpha is dropped
     attributeDescriptions[1].binding = 0;
     attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-    attributeDescriptions[1].offset = offsetof(PhysicsObject::Vertex, color);
+    attributeDescriptions[1].format = vertexFormat == VertexFormat::Float ? VK_FORMAT_R32G32B32_SFLOAT : VK_FORMAT_R8G8B8A8_UNORM;
+    attributeDescriptions[1].offset = vertexFormat == VertexFormat::Float ? static_cast<uint32_t>(offsetof(BodyVertex, color))
+                                                                          : static_cast<uint32_t>(getVertexStride(vertexFormat) - sizeof(uint32_t));
+    
+    // Instance position, scale and RGBA8 tint
+    attributeDescriptions[2].binding = 1;
+    attributeDescriptions[2].location = 2;
+    attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[2].offset = offsetof(BodyInstance, position);
+    attributeDescriptions[3].binding = 1;
+    attributeDescriptions[3].location = 3;
+    attributeDescriptions[3].format = VK_FORMAT_R32_SFLOAT;
+    attributeDescriptions[3].offset = offsetof(BodyInstance, scale);
+    attributeDescriptions[4].binding = 1;
+    attributeDescriptions[4].location = 4;
+    attributeDescriptions[4].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attributeDescriptions[4].offset = offsetof(BodyInstance, color);
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
     
@@ -917,46 +1004,12 @@ void createCommandBuffer() {
 void createVertexBuffer() {
     cout << "Creating vertex buffer..." << endl;
     
-    // Create large enough vertex buffer to accommodate all physics objects
-    VkDeviceSize bufferSize = 1000 * sizeof(PhysicsObject::Vertex); // Reserve space
-    
-    VkBufferCreateInfo bufferInfo = {};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = bufferSize;
-    bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    
-    if (vkCreateBuffer(device, &bufferInfo, nullptr, &vertexBuffer) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create vertex buffer!");
-    }
-    
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(device, vertexBuffer, &memRequirements);
-    
-    VkMemoryAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-    if (vkAllocateMemory(device, &allocInfo, nullptr, &vertexBufferMemory) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate vertex buffer memory!");
-    }
-    
-    vkBindBufferMemory(device, vertexBuffer, vertexBufferMemory, 0);
-    cout << "Vertex buffer created successfully" << endl;
-}
-
-uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-    
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
-    }
-    
-    throw std::runtime_error("failed to find suitable memory type!");
+    // Starts small and grows geometrically with the scene
+    vertexStorage.init(physicalDevice, device, MAX_FRAMES_IN_FLIGHT, getVertexStride(vertexFormat), 4096);
+    instanceStorage.init(physicalDevice, device, MAX_FRAMES_IN_FLIGHT, sizeof(BodyInstance), 1024);
+    regionMeshVersions.assign(MAX_FRAMES_IN_FLIGHT, ~0ull);
+    cout << "Vertex buffer created successfully (" << toString(vertexFormat) << " vertices, "
+         << (vertexStorage.usesDirectWrite() ? "host-visible device memory" : "device memory with staging uploads") << ")" << endl;
 }
 
 void createSyncObjects() {
@@ -989,49 +1042,69 @@ void createSyncObjects() {
 void mainLoop() {
     cout << "Starting main loop..." << endl;
     
+    // Physics steps at its fixed rate on its own thread; rendering runs uncapped and interpolates
+    if (simulationThread) {
+        simulationThread->start();
+    }
+    
     int frameCount = 0;
+    bool traceKeyDown = false;
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
         
-        // Calculate frame time
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        float deltaTime = std::chrono::duration<float>(currentTime - lastFrameTime).count();
-        lastFrameTime = currentTime;
-        
-        // Limit frame time to avoid large time steps
-        deltaTime = std::min(deltaTime, 0.016f); // Max 16ms
+        drawFrame();
         
-        // Update physics engine
-        if (physicsEngine) {
-            physicsEngine->update(deltaTime);
+        bool traceKey = glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS;
+        if (traceKey && !traceKeyDown && Profiler::isEnabled()) {
+            Profiler::writeChromeTrace(tracePath);
+            cout << "Trace written to " << tracePath << endl;
         }
-        
-        drawFrame();
+        traceKeyDown = traceKey;
         
         frameCount++;
         if (frameCount % 60 == 0) {
-            cout << "Frame " << frameCount << " completed" << endl;
+            cout << "Frame " << frameCount << " completed";
+            GpuProfiler::Stats renderPass = gpuProfiler.getStats("render pass");
+            if (renderPass.samples > 0) {
+                cout << ", GPU render pass " << renderPass.averageMs << " ms avg (" << renderPass.minMs << " - "
+                     << renderPass.maxMs << ")";
+            }
+            cout << endl;
         }
     }
     
+    if (simulationThread) {
+        simulationThread->stop();
+        cout << "Simulation ran " << simulationThread->getStepCount() << " steps" << endl;
+    }
+    
     cout << "Main loop ended after " << frameCount << " frames" << endl;
     vkDeviceWaitIdle(device);
 }
 
 void drawFrame() {
+    PROFILE_ZONE("drawFrame");
     try {
         // Wait for previous frame to finish
-        vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        {
+            PROFILE_ZONE("wait for frame fence");
+            vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+        }
         
         // Acquire image from swap chain
         uint32_t imageIndex = 0;
-        VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+        VkResult result;
+        {
+            PROFILE_ZONE("acquire image");
+            result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+        }
         if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
             throw std::runtime_error("Failed to acquire swap chain image!");
         }
     
     // Check if a previous frame is using this image
     if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
+        PROFILE_ZONE("wait for image fence");
         vkWaitForFences(device, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
     }
     // Mark the image as now being in use by this frame
@@ -1065,8 +1138,11 @@ void drawFrame() {
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
     
-    if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    {
+        PROFILE_ZONE("submit");
+        if (vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
     }
     
     // Present frame
@@ -1080,7 +1156,10 @@ void drawFrame() {
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = &imageIndex;
     
-    vkQueuePresentKHR(graphicsQueue, &presentInfo);
+    {
+        PROFILE_ZONE("present");
+        vkQueuePresentKHR(graphicsQueue, &presentInfo);
+    }
     
         // Advance to next frame
         currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
@@ -1091,6 +1170,7 @@ void drawFrame() {
 }
 
 void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    PROFILE_ZONE("recordCommandBuffer");
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     
@@ -1098,6 +1178,17 @@ void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
     
+    // Collects this frame slot's timestamps from its previous use; its fence has already been waited on
+    gpuProfiler.beginFrame(commandBuffer, static_cast<uint32_t>(currentFrame));
+    
+    // Copy this frame's vertices and instances from staging into device memory before the render pass reads them
+    uint32_t uploadZone = gpuProfiler.beginZone(commandBuffer, "vertex upload");
+    vertexStorage.recordUpload(commandBuffer, vertexUploadBegin, vertexUploadEnd - vertexUploadBegin);
+    instanceStorage.recordUpload(commandBuffer, instanceUploadBegin, instanceUploadEnd - instanceUploadBegin);
+    gpuProfiler.endZone(commandBuffer, uploadZone);
+    
+    uint32_t renderPassZone = gpuProfiler.beginZone(commandBuffer, "render pass");
+    
     // Begin render pass
     VkRenderPassBeginInfo renderPassInfo = {};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -1115,43 +1206,56 @@ void recordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
     // Bind graphics pipeline
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
     
-    // Bind vertex buffer
-    VkBuffer vertexBuffers[] = {vertexBuffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-    
-    // Render all physics objects
-    if (!physicsObjects.empty()) {
-        // Calculate total vertices
-        uint32_t totalVertices = 0;
-        for (const auto& obj : physicsObjects) {
-            totalVertices += static_cast<uint32_t>(obj->getVertices().size());
-        }
-        
-        if (totalVertices > 0) {
-            vkCmdDraw(commandBuffer, totalVertices, 1, 0, 0);
+    // Bind this frame's regions of the vertex and instance buffers
+    VkBuffer vertexBuffers[] = {vertexStorage.getBuffer(), instanceStorage.getBuffer()};
+    VkDeviceSize offsets[] = {vertexStorage.getRegionOffset(), instanceStorage.getRegionOffset()};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers, offsets);
+    
+    // Render all physics objects: one instanced draw per mesh (geometry, coloured per instance), plus one for the deformed bodies
+    if (uploadedInstanceCount > 0) {
+        for (const InstanceDraw& draw : instanceBatcher->getDraws()) {
+            if (draw.vertexCount == 0 || draw.instanceCount == 0) continue;
+            vkCmdDraw(commandBuffer, draw.vertexCount, draw.instanceCount, draw.firstVertex, draw.firstInstance);
         }
     }
     
     // End render pass
     vkCmdEndRenderPass(commandBuffer);
+    gpuProfiler.endZone(commandBuffer, renderPassZone);
     
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record command buffer!");
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
     try {
         // 设置控制台编码
         setConsoleEncoding();
         
+        // --trace <file>: record zones from the start; --vertex-format <name>: GPU vertex layout
+        for (int i = 1; i + 1 < argc; i++) {
+            if (strcmp(argv[i], "--trace") == 0) {
+                tracePath = argv[i + 1];
+                Profiler::setThreadName("render");
+                Profiler::setEnabled(true);
+            }
+            if (strcmp(argv[i], "--vertex-format") == 0) {
+                vertexFormat = parseVertexFormat(argv[i + 1]);
+            }
+        }
+        
         initWindow();
         initVulkan();
         
         // Start the main rendering loop
         mainLoop();
         
+        if (Profiler::isEnabled()) {
+            Profiler::writeChromeTrace(tracePath);
+            cout << "Trace written to " << tracePath << endl;
+        }
+        
         // Cleanup
         cleanup();
         
@@ -1168,13 +1272,14 @@ void cleanup() {
     vkDeviceWaitIdle(device);
     
     // Cleanup Vulkan objects
+    gpuProfiler.destroy();
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
         vkDestroyFence(device, inFlightFences[i], nullptr);
     }
-    vkDestroyBuffer(device, vertexBuffer, nullptr);
-    vkFreeMemory(device, vertexBufferMemory, nullptr);
+    vertexStorage.destroy();
+    instanceStorage.destroy();
     
     // 清理命令缓冲区
     vkFreeCommandBuffers(device, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
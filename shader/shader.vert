@@ -1,13 +1,18 @@
 #version 450
 
-// 输入：顶点位置
+// 每个顶点：形状的局部坐标和颜色
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
 
+// 每个实例：物体位置、缩放（0 表示隐藏）和颜色
+layout(location = 2) in vec2 instancePosition;
+layout(location = 3) in float instanceScale;
+layout(location = 4) in vec4 instanceColor;
+
 // 输出给片元着色器
 layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
+    gl_Position = vec4(inPosition * instanceScale + instancePosition, 0.0, 1.0);
+    fragColor = inColor * instanceColor.rgb;
 }
\ No newline at end of file
@@ -3,9 +3,13 @@
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec3 inColor;
 
+layout(location = 2) in vec2 instancePosition;
+layout(location = 3) in float instanceScale;
+layout(location = 4) in vec4 instanceColor;
+
 layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = vec4(inPosition, 0.0, 1.0);
-    fragColor = inColor;
+    gl_Position = vec4(inPosition * instanceScale + instancePosition, 0.0, 1.0);
+    fragColor = inColor * instanceColor.rgb;
 }
@@ -0,0 +1,64 @@
+// Settled scenes must fall asleep: a stack of five boxes on the ground, and the generated pile
+// scene at 1000 and 2000 bodies. Each runs for up to 3000 steps (50 s) and passes once every body
+// is asleep.
+#include "PhysicsEngine.h"
+#include "Scene.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const int maxSteps = 3000;
+
+// Steps until no body is awake, or -1 if some still are after maxSteps
+int stepsToSleep(PhysicsEngine& engine) {
+    for (int step = 1; step <= maxSteps; step++) {
+        engine.update(1.0f / 60.0f);
+        if (engine.getAwakeCount() == 0) return step;
+    }
+    return -1;
+}
+
+bool check(const string& name, PhysicsEngine& engine) {
+    int steps = stepsToSleep(engine);
+    if (steps < 0) {
+        cout << name << ": " << engine.getAwakeCount() << " of " << engine.getObjectCount() << " bodies still awake after "
+             << maxSteps << " steps\n";
+        return false;
+    }
+    cout << name << ": asleep after " << steps << " steps\n";
+    return true;
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+
+    {
+        PhysicsEngine engine;
+        const float halfSize = 0.05f;
+        const glm::vec3 color(0.5f);
+        vector<BodyVertex> box = {{{-halfSize, -halfSize}, color}, {{halfSize, -halfSize}, color}, {{halfSize, halfSize}, color},
+                                  {{-halfSize, -halfSize}, color}, {{halfSize, halfSize}, color}, {{-halfSize, halfSize}, color}};
+        vector<BodyDesc> descs(5);
+        for (size_t i = 0; i < descs.size(); i++) {
+            descs[i].vertices = box;
+            descs[i].position = glm::vec2(0.0f, -0.8f + i * (2.0f * halfSize + 0.001f));
+        }
+        engine.addBodies(descs.data(), descs.size());
+        ok = check("stack", engine) && ok;
+    }
+
+    for (size_t bodyCount : {1000, 2000}) {
+        PhysicsEngine engine;
+        Scene::generate("pile", bodyCount, 1).applyTo(engine);
+        ok = check("pile " + to_string(bodyCount), engine) && ok;
+    }
+
+    cout << (ok ? "ok" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
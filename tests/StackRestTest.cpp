@@ -0,0 +1,68 @@
+// A stack of five 0.1 boxes on a static floor, left to settle for ten seconds with sleeping off so
+// the solver runs every step. Every box must end resting on the one below: touching (the hulls
+// still collide at the final positions), overlapping by no more than the solver's slop and a
+// little rounding, and without a residual velocity.
+#include "PhysicsEngine.h"
+#include "Narrowphase.h"
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+const float halfSize = 0.05f;
+const int boxCount = 5;
+const int steps = 600;
+const float maxOverlap = 0.001f;
+const float maxSpeed = 0.001f;
+
+vector<BodyVertex> makeBox(glm::vec2 halfExtents) {
+    const glm::vec3 color(0.5f);
+    glm::vec2 a(-halfExtents.x, -halfExtents.y), b(halfExtents.x, -halfExtents.y);
+    glm::vec2 c(halfExtents.x, halfExtents.y), d(-halfExtents.x, halfExtents.y);
+    return {{a, color}, {b, color}, {c, color}, {a, color}, {c, color}, {d, color}};
+}
+
+} // namespace
+
+int main() {
+    PhysicsEngine engine;
+    engine.setSleepingEnabled(false);
+
+    // Static floor well above the ground plane, then the boxes 1 mm apart
+    vector<BodyDesc> descs(boxCount + 1);
+    descs[0].vertices = makeBox(glm::vec2(1.0f, halfSize));
+    descs[0].mass = 0.0f;
+    descs[0].position = glm::vec2(0.0f, 0.0f);
+    for (int i = 1; i <= boxCount; i++) {
+        descs[i].vertices = makeBox(glm::vec2(halfSize));
+        descs[i].position = glm::vec2(0.0f, i * (2.0f * halfSize + 0.001f));
+    }
+    vector<BodyHandle> handles(descs.size());
+    engine.addBodies(descs.data(), descs.size(), handles.data());
+
+    for (int step = 0; step < steps; step++) {
+        engine.update(1.0f / 60.0f);
+    }
+
+    const BodyStore& bodies = engine.getBodies();
+    bool ok = true;
+    for (int i = 1; i <= boxCount; i++) {
+        uint32_t below = engine.getBodyIndex(handles[i - 1]);
+        uint32_t box = engine.getBodyIndex(handles[i]);
+        float gap = bodies.positions[box].y - bodies.positions[below].y - 2.0f * halfSize;
+        float speed = glm::length(bodies.velocities[box]);
+        ContactManifold manifold;
+        SeparatingAxis axis;
+        bool touching = collidePolygons(*bodies.shapes[below], bodies.positions[below], *bodies.shapes[box], bodies.positions[box],
+                                        manifold, axis);
+
+        cout << "box " << i << ": gap " << gap << ", speed " << speed << (touching ? "" : ", not touching") << "\n";
+        if (!touching || gap < -maxOverlap || gap > 0.0f || speed > maxSpeed) ok = false;
+    }
+
+    cout << (ok ? "ok" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}